@@ -1,8 +1,6 @@
 #version 450
 //Vertex attributes
-layout(location = 0) in vec3 vPos; // Vertex position in model space
-layout(location = 1) in vec3 vNormal; // Vertex normal in model space
-layout(location = 2) in vec2 vTexCoord; // vertex texture coordinate (UV)
+#include "vertexFormat.glsl"
 uniform mat4 _Model; // Model->World Matrix
 uniform mat4 _ViewProjection; // Combined View-> Projection matrix
 out vec3 Normal; // Output for next shader
@@ -15,11 +13,12 @@ out Surface
 }vs_out;
 void main()
 {
+	vec3 pos = getVertexPosition();
 	// transform vertex position to world space
-	vs_out.WorldPos = vec3(_Model * vec4(vPos,1.0));
+	vs_out.WorldPos = vec3(_Model * vec4(pos,1.0));
 	// transform vertex normal to world space using normal matrix
-	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
+	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * getVertexNormal();
 	vs_out.TexCoord = vTexCoord;
 	// Transform vertex position to homogeneous clip space
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
-}
\ No newline at end of file
+	gl_Position = _ViewProjection * _Model * vec4(pos,1.0);
+}
@@ -0,0 +1,36 @@
+//Vertex inputs for every ew::VertexFormat. Compile with ew::getVertexFormatDefines(format)
+layout(location = 0) in vec3 vPos; // Vertex position in model space, or [0,1] when quantized
+#ifdef PACKED_VERTEX
+layout(location = 1) in vec2 vNormalOct; // Octahedral encoded normal
+#else
+layout(location = 1) in vec3 vNormal; // Vertex normal in model space
+#endif
+layout(location = 2) in vec2 vTexCoord; // vertex texture coordinate (UV)
+#ifdef QUANTIZED_VERTEX
+uniform mat4 _Dequantize; // Set by ew::Mesh::draw(shader) and ew::Model::draw(shader)
+#endif
+
+// Inverse of ew::octEncode
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+vec3 getVertexPosition()
+{
+#ifdef QUANTIZED_VERTEX
+	return vec3(_Dequantize * vec4(vPos, 1.0));
+#else
+	return vPos;
+#endif
+}
+vec3 getVertexNormal()
+{
+#ifdef PACKED_VERTEX
+	return octDecode(vNormalOct);
+#else
+	return vNormal;
+#endif
+}
@@ -3,6 +3,8 @@
 
 #include <ew/external/glad.h>
 #include <ew/shader.h>
+#include <ew/shaderVariants.h>
+#include <ew/glState.h>
 #include <ew/model.h>
 #include <ew/camera.h>
 #include <ew/transform.h>
@@ -31,6 +33,11 @@ struct Material {
 	float Shininess = 128;
 }material;
 
+//Vertex layout of the monkey. Changing it in the UI reloads the model
+ew::VertexFormat vertexFormat = ew::VertexFormat::PACKED;
+bool vertexFormatChanged = false;
+size_t monkeyGpuBytes;
+
 ew::Camera camera;
 ew::Transform monkeyTransform;
 ew::CameraController cameraController;
@@ -47,13 +54,17 @@ int main() {
 	camera.aspectRatio = (float)screenWidth / screenHeight;
 	camera.fov = 60.0f; //Vertical field of view, in degrees
 
-	ew::Shader shader = ew::Shader("assets/lit.vert", "assets/lit.frag");
-	ew::Model monkeyModel = ew::Model("assets/suzanne.obj");
+	//One variant per vertex format. lit.vert decodes packed normals and quantized positions
+	ew::ShaderVariants litShaders("assets/lit.vert", "assets/lit.frag");
+	ew::ModelLoadOptions loadOptions;
+	loadOptions.vertexFormat = vertexFormat;
+	ew::Model monkeyModel = ew::Model("assets/suzanne.obj", loadOptions);
+	monkeyGpuBytes = monkeyModel.getGpuBytes();
 
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK); // Back face culling
-	glEnable(GL_DEPTH_TEST); // Depth testing
+	ew::GLState::enable(GL_CULL_FACE);
+	ew::GLState::cullFace(GL_BACK); // Back face culling
+	ew::GLState::enable(GL_DEPTH_TEST); // Depth testing
 
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
@@ -69,14 +80,23 @@ int main() {
 		cameraController.move(window, &camera, deltaTime);
 		monkeyTransform.rotation = glm::rotate(monkeyTransform.rotation, deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
 
-		glBindTextureUnit(0, brickTexture);
+		if (vertexFormatChanged) {
+			vertexFormatChanged = false;
+			monkeyModel.unload();
+			loadOptions.vertexFormat = vertexFormat;
+			monkeyModel = ew::Model("assets/suzanne.obj", loadOptions);
+			monkeyGpuBytes = monkeyModel.getGpuBytes();
+		}
+
+		ew::GLState::bindTextureUnit(0, brickTexture);
 
+		ew::Shader& shader = *litShaders.get(ew::getVertexFormatDefines(vertexFormat));
 		shader.use();
 		shader.setInt("_MainTex", 0);
 		shader.setVec3("_EyePos", camera.position);
 		// transform.modelMatrix() combines translation, rotation, and scale into a 4x4 model matrix
 		shader.setMat4("_Model", monkeyTransform.modelMatrix());
-		shader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+		shader.setMat4("_ViewProjection", camera.viewProjectionMatrix());
 
 		// set material values
 		shader.setFloat("_Material.Ka", material.Ka);
@@ -84,7 +104,7 @@ int main() {
 		shader.setFloat("_Material.Ks", material.Ks);
 		shader.setFloat("_Material.Shininess", material.Shininess);
 
-		monkeyModel.draw(); // Draws Monkey model using current shader
+		monkeyModel.draw(shader); // Draws Monkey model using current shader, which dequantizes PACKED_QUANTIZED positions
 
 
 		drawUI();
@@ -117,6 +137,15 @@ void drawUI() {
 		ImGui::SliderFloat("SpecularK", &material.Ks, 0.0f, 1.0f);
 		ImGui::SliderFloat("Shininess", &material.Shininess, 2.0f, 1024.0f);
 	}
+	if (ImGui::CollapsingHeader("Vertex Format")) {
+		const char* formatNames[] = { "Standard (32 B)", "Packed (20 B)", "Packed Quantized (16 B)" };
+		int format = (int)vertexFormat;
+		if (ImGui::Combo("Layout", &format, formatNames, IM_ARRAYSIZE(formatNames))) {
+			vertexFormat = (ew::VertexFormat)format;
+			vertexFormatChanged = true;
+		}
+		ImGui::Text("GPU memory: %.1f KB", monkeyGpuBytes / 1024.0f);
+	}
 	ImGui::End();
 
 	ImGui::Render();
@@ -3,7 +3,6 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 uniform sampler2D screenTexture;
-uniform bool horizontal;
 
 void main() 
 {
@@ -11,20 +10,15 @@ void main()
     vec2 tex_offset = 1.0 / textureSize(screenTexture, 0); 
     vec3 result = texture(screenTexture, TexCoords).rgb * weight[0];
 
-    if (horizontal) 
+#ifdef HORIZONTAL
+    vec2 direction = vec2(tex_offset.x, 0.0);
+#else
+    vec2 direction = vec2(0.0, tex_offset.y);
+#endif
+    for (int i = 1; i < 5; ++i) 
     {
-        for (int i = 1; i < 5; ++i) 
-        {
-            result += texture(screenTexture, TexCoords + vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
-            result += texture(screenTexture, TexCoords - vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
-        }
-    } else 
-    {
-        for (int i = 1; i < 5; ++i) 
-        {
-            result += texture(screenTexture, TexCoords + vec2(0.0, tex_offset.y * i)).rgb * weight[i];
-            result += texture(screenTexture, TexCoords - vec2(0.0, tex_offset.y * i)).rgb * weight[i];
-        }
+        result += texture(screenTexture, TexCoords + direction * i).rgb * weight[i];
+        result += texture(screenTexture, TexCoords - direction * i).rgb * weight[i];
     }
 
     FragColor = vec4(result, 1.0);
@@ -3,6 +3,8 @@
 #include <GLFW/glfw3.h>
 
 #include "ew/shader.h"
+#include "ew/glState.h"
+#include "ew/shaderVariants.h"
 #include "ew/camera.h"
 #include "ew/texture.h"
 #include "ew/mesh.h"
@@ -24,7 +26,7 @@ GLuint blurFBO[2], blurTexture[2];
 GLuint quadVAO, quadVBO, quadEBO;
 Shader* sceneShader;
 Shader* gammaShader;
-Shader* blurShader;
+ShaderVariants* blurShaders;
 Camera camera;
 Model* suzanneModel;
 
@@ -35,11 +37,11 @@ bool useBlur = false;
 void setupFramebuffer()
 {
     glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     // Color texture
     glGenTextures(1, &colorTexture);
-    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, colorTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -55,21 +57,21 @@ void setupFramebuffer()
     {
         std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // Blur Framebuffers
     glGenFramebuffers(2, blurFBO);
     glGenTextures(2, blurTexture);
     for (unsigned int i = 0; i < 2; i++) 
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, blurFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, blurTexture[i]);
+        ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, blurFBO[i]);
+        ew::GLState::bindTexture(GL_TEXTURE_2D, blurTexture[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurTexture[i], 0);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 // fullscreen quad
@@ -88,7 +90,7 @@ void setupQuad()
     glGenBuffers(1, &quadVBO);
     glGenBuffers(1, &quadEBO);
 
-    glBindVertexArray(quadVAO);
+    ew::GLState::bindVertexArray(quadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
@@ -100,7 +102,7 @@ void setupQuad()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    glBindVertexArray(0);
+    ew::GLState::bindVertexArray(0);
 }
 
 void renderScene()
@@ -126,34 +128,36 @@ void renderScene()
 
 void renderPostProcess()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // Render to screen
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0); // Render to screen
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (useBlur) {
         bool horizontal = true, first_iteration = true;
         int blurAmount = 10;
 
-        blurShader->use();
+        // Blur direction is compiled into separate variants instead of branching per fragment
+        Shader* horizontalBlur = blurShaders->get({ "HORIZONTAL" });
+        Shader* verticalBlur = blurShaders->get({});
         for (unsigned int i = 0; i < blurAmount; i++) {
-            glBindFramebuffer(GL_FRAMEBUFFER, blurFBO[horizontal]);
-            blurShader->setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorTexture : blurTexture[!horizontal]);
-            glBindVertexArray(quadVAO);
+            ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, blurFBO[horizontal]);
+            (horizontal ? horizontalBlur : verticalBlur)->use();
+            ew::GLState::bindTexture(GL_TEXTURE_2D, first_iteration ? colorTexture : blurTexture[!horizontal]);
+            ew::GLState::bindVertexArray(quadVAO);
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
             horizontal = !horizontal;
             if (first_iteration) first_iteration = false;
         }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glBindTexture(GL_TEXTURE_2D, blurTexture[!horizontal]);
+        ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+        ew::GLState::bindTexture(GL_TEXTURE_2D, blurTexture[!horizontal]);
     }
     else {
         gammaShader->use();
         gammaShader->setFloat("gamma", gammaValue);
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        ew::GLState::bindTexture(GL_TEXTURE_2D, colorTexture);
     }
 
-    glBindVertexArray(quadVAO);
+    ew::GLState::bindVertexArray(quadVAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 }
 
@@ -182,14 +186,14 @@ int main()
     }
 
     // Setup OpenGL
-    glEnable(GL_DEPTH_TEST);
+    ew::GLState::enable(GL_DEPTH_TEST);
     setupFramebuffer();
     setupQuad();
     
     suzanneModel = new Model("assets/Suzanne.obj");
     sceneShader = new Shader("assets/scene.vert", "assets/scene.frag");
     gammaShader = new Shader("assets/postprocess.vert", "assets/gamma.frag");
-    blurShader = new Shader("assets/postprocess.vert", "assets/postprocess.frag");
+    blurShaders = new ShaderVariants("assets/postprocess.vert", "assets/postprocess.frag");
 
     // Setup ImGui
     IMGUI_CHECKVERSION();
@@ -209,7 +213,7 @@ int main()
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         renderScene();
 
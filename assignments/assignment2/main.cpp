@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 
 #include "ew/shader.h"
+#include "ew/glState.h"
 #include "ew/camera.h"
 #include "ew/texture.h"
 #include "ew/mesh.h"
@@ -40,7 +41,7 @@ bool showShadowMap = false;
 
 glm::mat4 inverseViewProjectionMatrix()
 {
-    glm::mat4 viewProj = camera.projectionMatrix() * camera.viewMatrix();
+    glm::mat4 viewProj = camera.viewProjectionMatrix();
     return glm::inverse(viewProj);
 }
 
@@ -57,7 +58,7 @@ void setupShadowFramebuffer()
     glGenFramebuffers(1, &shadowFBO);
     glGenTextures(1, &shadowMap);
 
-    glBindTexture(GL_TEXTURE_2D, shadowMap);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, shadowMap);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -66,22 +67,22 @@ void setupShadowFramebuffer()
     float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
     glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
 
 void setupGBuffer() {
     glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
 
     // Position color buffer
     glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gPosition);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -89,7 +90,7 @@ void setupGBuffer() {
 
     // Normal color buffer
     glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gNormal);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -97,7 +98,7 @@ void setupGBuffer() {
 
     // Albedo + specular color buffer
     glGenTextures(1, &gAlbedoSpec);
-    glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gAlbedoSpec);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -109,7 +110,7 @@ void setupGBuffer() {
 
     // Create and attach depth buffer (renderbuffer)
     glGenTextures(1, &depthTexture);
-    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, depthTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -119,7 +120,7 @@ void setupGBuffer() {
     // Check
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void setupCube() {
@@ -171,7 +172,7 @@ void setupCube() {
     GLuint cubeVBO;
     glGenVertexArrays(1, &cubeVAO);
     glGenBuffers(1, &cubeVBO);
-    glBindVertexArray(cubeVAO);
+    ew::GLState::bindVertexArray(cubeVAO);
     glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -180,7 +181,7 @@ void setupCube() {
 
 void renderUnitCube()
 {
-    glBindVertexArray(cubeVAO);
+    ew::GLState::bindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
 }
 
@@ -203,7 +204,7 @@ void renderUnitQuad()
         };
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        ew::GLState::bindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -211,7 +212,7 @@ void renderUnitQuad()
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    ew::GLState::bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -230,7 +231,7 @@ void setupPlane()
 
     glGenVertexArrays(1, &planeVAO);
     glGenBuffers(1, &planeVBO);
-    glBindVertexArray(planeVAO);
+    ew::GLState::bindVertexArray(planeVAO);
 
     glGenBuffers(1, &planeEBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEBO);
@@ -246,7 +247,7 @@ void setupPlane()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    ew::GLState::bindVertexArray(0);
 }
 
 void computeLightSpaceMatrix()
@@ -265,7 +266,7 @@ void renderScene(Shader& shader)
 
     glm::mat4 model = glm::mat4(1.0f);
     shader.setMat4("model", model);
-    glBindVertexArray(planeVAO);
+    ew::GLState::bindVertexArray(planeVAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
     model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
@@ -277,15 +278,15 @@ void renderShadowPass()
 {
     shadowShader->use();
     glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
     glClear(GL_DEPTH_BUFFER_BIT);
     renderScene(*shadowShader);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void renderGeometryPass() 
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -293,17 +294,17 @@ void renderGeometryPass()
     geometryShader->setMat4("view", camera.viewMatrix());
     geometryShader->setMat4("projection", camera.projectionMatrix());
     geometryShader->setInt("texture_diffuse1", 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, brickTexture);
+    ew::GLState::activeTexture(GL_TEXTURE0);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, brickTexture);
 
     renderScene(*geometryShader);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 }
 
 void renderDecals() {
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer); // <-- modify GBuffer directly
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer); // <-- modify GBuffer directly
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
     decalShader->use();
@@ -311,18 +312,18 @@ void renderDecals() {
     decalShader->setInt("depthMap", 0);
     decalShader->setMat4("invViewProj", inverseViewProjectionMatrix());
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    ew::GLState::activeTexture(GL_TEXTURE0);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, depthTexture);
 
     // Render your decal boxes here
     for (Decal& decal : decalList) {
         decalShader->setMat4("decalModel", decal.modelMatrix);
         decalShader->setInt("decalTexture", 1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, decal.texture);
+        ew::GLState::activeTexture(GL_TEXTURE1);
+        ew::GLState::bindTexture(GL_TEXTURE_2D, decal.texture);
         renderUnitCube();
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
@@ -337,12 +338,12 @@ void renderLightingPass()
     lightingShader->setInt("gAlbedoSpec", 2);
     lightingShader->setVec3("lightDir", lightDirection);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
+    ew::GLState::activeTexture(GL_TEXTURE0);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gPosition);
+    ew::GLState::activeTexture(GL_TEXTURE1);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gNormal);
+    ew::GLState::activeTexture(GL_TEXTURE2);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gAlbedoSpec);
 
     renderUnitQuad();
 
@@ -421,7 +422,7 @@ int main()
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
-    glEnable(GL_DEPTH_TEST);
+    ew::GLState::enable(GL_DEPTH_TEST);
     setupShadowFramebuffer();
     setupPlane();
     setupGBuffer();
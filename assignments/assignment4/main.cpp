@@ -6,6 +6,7 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <ew/shader.h>
+#include <ew/glState.h>
 #include <ew/model.h>
 #include <ew/camera.h>
 #include <ew/transform.h>
@@ -13,6 +14,7 @@
 #include <ew/texture.h>
 #include <ew/procGen.h>
 #include <dawslib/animation.h>
+#include <dawslib/animationBenchmark.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 GLFWwindow* initWindow(const char* title, int width, int height);
@@ -24,6 +26,8 @@ void resetCamera(ew::Camera* camera, ew::CameraController* controller);
 ew::Camera camera;
 ew::Transform monkeyTransform;
 ew::CameraController cameraController;
+dawslib::ClipLibrary clipLibrary;
+dawslib::ClipHandle clipHandle;
 dawslib::Animator animator;
 
 int screenWidth = 1080;
@@ -69,13 +73,24 @@ void drawUI()
 void AnimatorUI() 
 {
     const char* easingNames[] = { "Lerp", "In Out Sine", "In Out Quart", "In Out Back" };
+    dawslib::AnimationClip* clip = clipLibrary.Edit(clipHandle);
 
     ImGui::Begin("Animator Settings");
     ImGui::Checkbox("Playing", &animator.isPlaying);
     ImGui::Checkbox("Looping", &animator.isLooping);
     ImGui::SliderFloat("Playback Speed", &animator.playbackSpeed, -5.0f, 5.0f);
-    ImGui::SliderFloat("Playback Time", &animator.playbackTime, 0.0f, animator.clip->duration);
-    ImGui::DragFloat("Duration", &animator.clip->duration);
+    ImGui::SliderFloat("Playback Time", &animator.playbackTime, 0.0f, clip->duration);
+    ImGui::DragFloat("Duration", &clip->duration);
+    // Prints key lookup timings for clips of 2 to 100K keys to the console
+    if (ImGui::Button("Benchmark Key Lookup"))
+    {
+        dawslib::BenchmarkKeyframeLookupSweep();
+    }
+    // Prints Animator vs AnimationSystem update times for 1K to 256K animators to the console
+    if (ImGui::Button("Benchmark Animation System"))
+    {
+        dawslib::BenchmarkAnimationSystemSweep();
+    }
 
     auto drawKeyframes = [&](const char* label, std::vector<dawslib::Vec3Key>& keys, const glm::vec3& defaultValue) 
     {
@@ -84,7 +99,11 @@ void AnimatorUI()
             for (size_t i = 0; i < keys.size(); ++i) 
             {
                 ImGui::PushID((std::string(label) + std::to_string(i)).c_str());  
-                ImGui::SliderFloat("Time", &keys[i].mTime, 0.0f, animator.clip->duration);
+                // Keys stay sorted by time, which the animator's key lookup relies on
+                float minTime = i > 0 ? keys[i - 1].mTime : 0.0f;
+                float maxTime = i + 1 < keys.size() ? keys[i + 1].mTime : std::max(clip->duration, minTime);
+                ImGui::SliderFloat("Time", &keys[i].mTime, minTime, maxTime);
+                keys[i].mTime = glm::clamp(keys[i].mTime, minTime, maxTime);
                 ImGui::DragFloat3("Value", &keys[i].mValue.x, 0.1f);
                 ImGui::Combo("Interpolation Method", &keys[i].mMethod, easingNames, IM_ARRAYSIZE(easingNames));
                 ImGui::PopID();
@@ -94,7 +113,8 @@ void AnimatorUI()
             if (ImGui::Button(std::string("Add " + std::string(label)).c_str()))
             {
                 glm::vec3 lastValue = keys.empty() ? defaultValue : keys.back().mValue;
-                keys.emplace_back(animator.clip->duration, lastValue);
+                float time = keys.empty() ? clip->duration : std::max(clip->duration, keys.back().mTime);
+                keys.emplace_back(time, lastValue);
             }
             ImGui::SameLine();
             if (ImGui::Button(std::string("Remove " + std::string(label)).c_str()) && !keys.empty())
@@ -105,9 +125,9 @@ void AnimatorUI()
         }
     };
 
-    drawKeyframes("Position Keys", animator.clip->positionKeys, glm::vec3(0.0f));
-    drawKeyframes("Rotation Keys", animator.clip->rotationKeys, glm::vec3(0.0f));
-    drawKeyframes("Scale Keys", animator.clip->scaleKeys, glm::vec3(1.0f));
+    drawKeyframes("Position Keys", clip->positionKeys, glm::vec3(0.0f));
+    drawKeyframes("Rotation Keys", clip->rotationKeys, glm::vec3(0.0f));
+    drawKeyframes("Scale Keys", clip->scaleKeys, glm::vec3(1.0f));
 
     ImGui::End();
 }
@@ -184,14 +204,16 @@ int main()
     camera.aspectRatio = (float)screenWidth / screenHeight;
     camera.fov = 60.0f;
 
-    animator.clip = new dawslib::AnimationClip();
-    animator.clip->duration = 5;
+    dawslib::AnimationClip clip;
+    clip.duration = 5;
+    clipHandle = clipLibrary.Add(std::move(clip));
+    animator.SetClip(clipLibrary, clipHandle);
     animator.isPlaying = true;
     animator.isLooping = true;
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glEnable(GL_DEPTH_TEST);
+    ew::GLState::enable(GL_CULL_FACE);
+    ew::GLState::cullFace(GL_BACK);
+    ew::GLState::enable(GL_DEPTH_TEST);
 
     while (!glfwWindowShouldClose(window)) 
     {
@@ -206,9 +228,9 @@ int main()
         animator.Update(deltaTime);
 
         // Ensure transformations are applied independently
-        glm::vec3 newPosition = animator.GetValue(animator.clip->positionKeys, glm::vec3(0));
-        glm::vec3 newRotation = animator.GetValue(animator.clip->rotationKeys, glm::vec3(0));
-        glm::vec3 newScale = animator.GetValue(animator.clip->scaleKeys, glm::vec3(1));
+        glm::vec3 newPosition = animator.GetPosition();
+        glm::vec3 newRotation = animator.GetRotation();
+        glm::vec3 newScale = animator.GetScale();
 
         // Apply position
         monkeyTransform.position = newPosition;
@@ -222,12 +244,12 @@ int main()
         glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glBindTextureUnit(0, brickTexture);
+        ew::GLState::bindTextureUnit(0, brickTexture);
 
         shader.use();
         shader.setVec3("_EyePos", camera.position);
         shader.setInt("_MainTex", 0);
-        shader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+        shader.setMat4("_ViewProjection", camera.viewProjectionMatrix());
         shader.setFloat("_Material.Ka", material.Ka);
         shader.setFloat("_Material.Kd", material.Kd);
         shader.setFloat("_Material.Ks", material.Ks);
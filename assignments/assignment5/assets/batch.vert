@@ -0,0 +1,38 @@
+#version 450
+// Vertex shader for ew::BatchRenderer draws. Outputs match shader.vert
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vTexCoord;
+
+#ifdef BATCH_INDIRECT
+layout(location = 3) in uint _DrawID;
+layout(std430, binding = 0) readonly buffer _Transforms
+{
+	mat4 _Models[];
+};
+#else
+uniform mat4 _Model;
+#endif
+#include "uniformBlocks.glsl"
+
+out Surface
+{
+	vec3 worldPos;
+	vec3 worldNormal;
+	vec2 texCoord;
+	vec4 fragPosLightSpace;
+}vs_out;
+
+void main()
+{
+#ifdef BATCH_INDIRECT
+	mat4 model = _Models[_DrawID];
+#else
+	mat4 model = _Model;
+#endif
+	vs_out.worldPos = vec3(model * vec4(vPos, 1.0));
+	vs_out.worldNormal = transpose(inverse(mat3(model))) * vNormal;
+	vs_out.texCoord = vTexCoord;
+	vs_out.fragPosLightSpace = _LightSpaceMatrix * vec4(vs_out.worldPos, 1.0);
+	gl_Position = _ViewProjection * vec4(vs_out.worldPos, 1.0);
+}
@@ -3,7 +3,7 @@
 layout(location = 0) in vec3 vPos;
 
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
+#include "uniformBlocks.glsl"
 
 void main()
 {
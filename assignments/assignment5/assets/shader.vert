@@ -5,8 +5,7 @@ layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vTexCoord;
 
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
-uniform mat4 _LightSpaceMatrix;
+#include "uniformBlocks.glsl"
 
 out Surface
 {
@@ -5,6 +5,11 @@
 
 #include <ew/external/glad.h>
 #include <ew/shader.h>
+#include <ew/uniformBuffer.h>
+#include <ew/shaderVariants.h>
+#include <ew/meshPool.h>
+#include <ew/batchRenderer.h>
+#include <ew/glState.h>
 #include <ew/model.h>
 #include <ew/camera.h>
 #include <ew/transform.h>
@@ -48,6 +53,7 @@ struct Material
 
 Material material;
 bool shadowToggle = true;
+bool indirectBatching = true;
 float minBias = 0.005f;
 float maxBias = 0.05f;
 
@@ -179,7 +185,7 @@ void drawSpline(const Spline& input)
 		glGenBuffers(1, &vbo);
 	}
 
-	glBindVertexArray(vao);
+	ew::GLState::bindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
 	for (int i = 0; i < splineSegments; i++) 
@@ -276,6 +282,13 @@ int main()
 	ew::Mesh pointLight = ew::Mesh(pointLightData);
 	ew::MeshData splinePointData = ew::createSphere(0.1f, 20);
 	ew::Mesh splinePoint = ew::Mesh(splinePointData);
+	//Spline control points share one pool and are drawn with one batch per pass
+	ew::MeshPool pointPool;
+	ew::MeshPoolHandle pointLightHandle = pointPool.add(pointLightData);
+	ew::MeshPoolHandle splinePointHandle = pointPool.add(splinePointData);
+	ew::BatchRenderer pointBatch(&pointPool, 256);
+	ew::ShaderVariants batchShadowShaders("assets/batch.vert", "assets/light.frag");
+	ew::ShaderVariants batchShadedShaders("assets/batch.vert", "assets/shader.frag");
 	ew::Transform monkeyTrans;
 	ew::Transform planeTrans;
 	ew::Transform lightTrans;
@@ -283,6 +296,14 @@ int main()
 	ew::Transform linesTrans;
 	GLuint brickTexture = ew::loadTexture("assets/brick_color.jpg");
 
+	//Per frame, per view and material data shared by every shader through the standard uniform blocks
+	ew::UniformBuffer<ew::FrameBlock> frameBuffer;
+	ew::UniformBuffer<ew::ViewBlock> cameraViewBuffer;
+	ew::UniformBuffer<ew::ViewBlock> lightViewBuffer;
+	ew::UniformBuffer<ew::MaterialBlock> materialBuffer;
+	frameBuffer.bind(ew::UniformBlockBinding::FRAME);
+	materialBuffer.bind(ew::UniformBlockBinding::MATERIAL);
+
 	cam.position = glm::vec3(0.0f, 0.0f, 5.0f);
 	cam.target = glm::vec3(0.0f, 0.0f, 0.0f);
 	cam.aspectRatio = (float)screenWidth / screenHeight;
@@ -301,20 +322,20 @@ int main()
 
 	planeTrans.position = glm::vec3(0.0f, -10.0f, 0.0f);
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST); 
-	glDepthFunc(GL_LESS);
+	ew::GLState::enable(GL_CULL_FACE);
+	ew::GLState::cullFace(GL_BACK);
+	ew::GLState::enable(GL_DEPTH_TEST); 
+	ew::GLState::depthFunc(GL_LESS);
 
 	unsigned int fbo;
 	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
 
 	glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	glGenTextures(1, &depthMap);
-	glBindTexture(GL_TEXTURE_2D, depthMap);
+	ew::GLState::bindTexture(GL_TEXTURE_2D, depthMap);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, screenWidth, screenHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -323,13 +344,13 @@ int main()
 	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	glBindTextureUnit(0, brickTexture);
+	ew::GLState::bindTextureUnit(0, brickTexture);
 
 	CreateSpline();
 
@@ -340,10 +361,8 @@ int main()
 		light.aspectRatio = (float)screenWidth / screenHeight;
 		light.position = -lightDir;
 		lightTrans.position = -lightDir;
-		shadow.setVec3("_EyePos", light.position);
 		cam.aspectRatio = (float)screenWidth / screenHeight;
 		camCon.move(window, &cam, deltaTime);
-		shader.setVec3("_EyePos", cam.position);
 
 	// Make suzzane face the direction of the spline
 		for (int i = 0; i < splines.size(); i++)
@@ -371,62 +390,71 @@ int main()
 		deltaTime = time - prevFrameTime;
 		prevFrameTime = time;
 
+		ew::FrameBlock frameData;
+		frameData.time = time;
+		frameData.deltaTime = deltaTime;
+		frameData.lightDirection = glm::vec4(glm::normalize(lightDir), 0.0f);
+		frameData.lightSpaceMatrix = light.viewProjectionMatrix();
+		frameBuffer.set(frameData);
+		cameraViewBuffer.set(ew::makeViewBlock(cam));
+		lightViewBuffer.set(ew::makeViewBlock(light));
+		ew::MaterialBlock materialData;
+		materialData.ka = material.Ka;
+		materialData.kd = material.Kd;
+		materialData.ks = material.Ks;
+		materialData.shininess = material.Shiny;
+		materialBuffer.set(materialData);
+
 
 		glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glClear(GL_DEPTH_BUFFER_BIT);
-
-		glCullFace(GL_FRONT);
-		shadow.use();
-		shadow.setMat4("_Model", monkeyTrans.modelMatrix());
-		shadow.setMat4("_ViewProjection", light.projectionMatrix() * light.viewMatrix());
-		shadow.setFloat("_Material.Ka", material.Ka);
-		shadow.setFloat("_Material.Kd", material.Kd);
-		shadow.setFloat("_Material.Ks", material.Ks);
-		shadow.setFloat("_Material.Shininess", material.Shiny);
-		monkey.draw();
-
-		glCullFace(GL_BACK);
-		shadow.setMat4("_Model", planeTrans.modelMatrix());
-		plane.draw();
-
+		pointBatch.begin();
 		pointsTrans.position = VecFy(splines[0]->controls[0].pos);
 		pointsTrans.rotation = eulToQuat(splines[0]->controls[0].rot);
-		shadow.setMat4("_Model", pointsTrans.modelMatrix());
-		splinePoint.draw();
-		for (int i = 0; i < splines.size(); i++) 
+		pointBatch.submit(splinePointHandle, pointsTrans.modelMatrix());
+		for (int i = 0; i < splines.size(); i++)
 		{
 			pointsTrans.position = VecFy(splines[i]->controls[1].pos);
 			pointsTrans.rotation = eulToQuat(splines[i]->controls[1].rot);
-			shadow.setMat4("_Model", pointsTrans.modelMatrix());
-			pointLight.draw();
+			pointBatch.submit(pointLightHandle, pointsTrans.modelMatrix());
 			pointsTrans.position = VecFy(splines[i]->controls[2].pos);
 			pointsTrans.rotation = eulToQuat(splines[i]->controls[2].rot);
-			shadow.setMat4("_Model", pointsTrans.modelMatrix());
-			pointLight.draw();
+			pointBatch.submit(pointLightHandle, pointsTrans.modelMatrix());
 			pointsTrans.position = VecFy(splines[i]->controls[3].pos);
 			pointsTrans.rotation = eulToQuat(splines[i]->controls[3].rot);
-			shadow.setMat4("_Model", pointsTrans.modelMatrix());
-			splinePoint.draw();
+			pointBatch.submit(splinePointHandle, pointsTrans.modelMatrix());
 		}
+		pointBatch.setUseIndirect(indirectBatching);
+		ew::Shader& batchShadow = *batchShadowShaders.get(pointBatch.getShaderDefines());
+		ew::Shader& batchShaded = *batchShadedShaders.get(pointBatch.getShaderDefines());
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glCullFace(GL_BACK);
+		ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		ew::GLState::cullFace(GL_FRONT);
+		lightViewBuffer.bind(ew::UniformBlockBinding::VIEW);
+		shadow.use();
+		shadow.setMat4("_Model", monkeyTrans.modelMatrix());
+		monkey.draw();
+
+		ew::GLState::cullFace(GL_BACK);
+		shadow.setMat4("_Model", planeTrans.modelMatrix());
+		plane.draw();
+
+		batchShadow.use();
+		pointBatch.flush(batchShadow);
+
+		ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+		ew::GLState::cullFace(GL_BACK);
+		cameraViewBuffer.bind(ew::UniformBlockBinding::VIEW);
 
 		if (shadowToggle)
 		{
-			glBindTextureUnit(0, depthMap);
-			glBindTextureUnit(1, depthMap);
+			ew::GLState::bindTextureUnit(0, depthMap);
+			ew::GLState::bindTextureUnit(1, depthMap);
 			shaded.use();
 			shaded.setMat4("_Model", planeTrans.modelMatrix());
-			shaded.setMat4("_ViewProjection", cam.projectionMatrix() * cam.viewMatrix());
-			shaded.setFloat("_Material.Ka", material.Ka);
-			shaded.setFloat("_Material.Kd", material.Kd);
-			shaded.setFloat("_Material.Ks", material.Ks);
-			shaded.setFloat("_Material.Shininess", material.Shiny);
-			shaded.setMat4("_LightSpaceMatrix", light.projectionMatrix() * light.viewMatrix());
 			shaded.setInt("_ShadowMap", 1);
 			shaded.setInt("_MainTex", 0);
 			shaded.setVec3("_ShadowMapDirection", light.position);
@@ -434,48 +462,36 @@ int main()
 			shaded.setFloat("_MaxBias", maxBias);
 			plane.draw();
 
-			glBindTextureUnit(0, brickTexture);
+			ew::GLState::bindTextureUnit(0, brickTexture);
 			shaded.setMat4("_Model", monkeyTrans.modelMatrix());
 			monkey.draw();
 
 			shaded.setMat4("_Model", lightTrans.modelMatrix());
 			pointLight.draw();
 
-			pointsTrans.position = VecFy(splines[0]->controls[0].pos);
-			pointsTrans.rotation = eulToQuat(splines[0]->controls[0].rot);
-			shaded.setMat4("_Model", pointsTrans.modelMatrix());
-			splinePoint.draw();
+			batchShaded.use();
+			batchShaded.setInt("_ShadowMap", 1);
+			batchShaded.setInt("_MainTex", 0);
+			batchShaded.setVec3("_ShadowMapDirection", light.position);
+			batchShaded.setFloat("_MinBias", minBias);
+			batchShaded.setFloat("_MaxBias", maxBias);
+			pointBatch.flush(batchShaded);
+
+			shaded.use();
 			for (int i = 0; i < splines.size(); i++)
 			{
-				pointsTrans.position = VecFy(splines[i]->controls[1].pos);
-				pointsTrans.rotation = eulToQuat(splines[i]->controls[1].rot);
-				shaded.setMat4("_Model", pointsTrans.modelMatrix());
-				pointLight.draw();
-				pointsTrans.position = VecFy(splines[i]->controls[2].pos);
-				pointsTrans.rotation = eulToQuat(splines[i]->controls[2].rot);
-				shaded.setMat4("_Model", pointsTrans.modelMatrix());
-				pointLight.draw();
-				pointsTrans.position = VecFy(splines[i]->controls[3].pos);
-				pointsTrans.rotation = eulToQuat(splines[i]->controls[3].rot);
-				shaded.setMat4("_Model", pointsTrans.modelMatrix());
-				splinePoint.draw();
 				shaded.setMat4("_Model", linesTrans.modelMatrix());
 				drawSpline(*splines[i]);
 			}
 		}
 		else
 		{
-			glBindTextureUnit(0, depthMap);
+			ew::GLState::bindTextureUnit(0, depthMap);
 			shader.use();
 			shader.setMat4("_Model", planeTrans.modelMatrix());
-			shader.setMat4("_ViewProjection", cam.projectionMatrix() * cam.viewMatrix());
-			shader.setFloat("_Material.Ka", material.Ka);
-			shader.setFloat("_Material.Kd", material.Kd);
-			shader.setFloat("_Material.Ks", material.Ks);
-			shader.setFloat("_Material.Shininess", material.Shiny);
 			plane.draw();
 
-			glBindTextureUnit(0, brickTexture);
+			ew::GLState::bindTextureUnit(0, brickTexture);
 			shader.setMat4("_Model", monkeyTrans.modelMatrix());
 			monkey.draw();
 
@@ -483,25 +499,19 @@ int main()
 			pointLight.draw();
 
 
-			pointsTrans.position = VecFy(splines[0]->controls[0].pos);
-			pointsTrans.rotation = eulToQuat(splines[0]->controls[0].rot);
-			shaded.setMat4("_Model", pointsTrans.modelMatrix());
-			splinePoint.draw();
-			for (int i = 0; i < splines.size(); i++) 
+			batchShaded.use();
+			batchShaded.setInt("_ShadowMap", 1);
+			batchShaded.setInt("_MainTex", 0);
+			batchShaded.setVec3("_ShadowMapDirection", light.position);
+			//A bias past the depth range turns the shadow test off
+			batchShaded.setFloat("_MinBias", 1.0f);
+			batchShaded.setFloat("_MaxBias", 1.0f);
+			pointBatch.flush(batchShaded);
+
+			shader.use();
+			for (int i = 0; i < splines.size(); i++)
 			{
-				pointsTrans.position = VecFy(splines[i]->controls[1].pos);
-				pointsTrans.rotation = eulToQuat(splines[i]->controls[1].rot);
-				shaded.setMat4("_Model", pointsTrans.modelMatrix());
-				pointLight.draw();
-				pointsTrans.position = VecFy(splines[i]->controls[2].pos);
-				pointsTrans.rotation = eulToQuat(splines[i]->controls[2].rot);
-				shaded.setMat4("_Model", pointsTrans.modelMatrix());
-				pointLight.draw();
-				pointsTrans.position = VecFy(splines[i]->controls[3].pos);
-				pointsTrans.rotation = eulToQuat(splines[i]->controls[3].rot);
-				shaded.setMat4("_Model", pointsTrans.modelMatrix());
-				splinePoint.draw();
-				shaded.setMat4("_Model", linesTrans.modelMatrix());
+				shader.setMat4("_Model", linesTrans.modelMatrix());
 				drawSpline(*splines[i]);
 			}
 		}
@@ -563,6 +573,8 @@ void drawUI()
 		if (shadowToggle) shadowToggle = false;
 		else shadowToggle = true;
 	}
+	//Off draws the spline control points one at a time, to compare against the indirect batch
+	ImGui::Checkbox("Indirect Batching", &indirectBatching);
 	if (ImGui::CollapsingHeader("Splines")) 
 	{
 		for (int i = 0; i < splines.size(); i++) 
@@ -2,10 +2,19 @@
 
 layout(location = 0) in vec3 vPos;
 
+#ifdef INSTANCED
+layout(location = 4) in mat4 iModel; // Per instance model matrix, see ew::InstanceBuffer
+#else
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
+#endif
+#include "uniformBlocks.glsl"
 
 void main()
 {
-	gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
+#ifdef INSTANCED
+	mat4 model = iModel;
+#else
+	mat4 model = _Model;
+#endif
+	gl_Position = _ViewProjection * model * vec4(vPos, 1.0);
 }
\ No newline at end of file
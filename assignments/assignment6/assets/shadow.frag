@@ -10,8 +10,7 @@ in Surface
 }fs_in;
 uniform sampler2D _MainTex;
 uniform sampler2D _ShadowMap;
-uniform vec3 _EyePos;
-uniform vec3 _LightDirection = vec3(0.0, -1.0, 0.0);
+#include "uniformBlocks.glsl"
 uniform vec3 _LightColor = vec3(1.0);
 uniform vec3 _AmbientColor = vec3(0.3,0.4,0.46);
 uniform vec3 _ShadowMapDirection;
@@ -20,15 +19,6 @@ uniform float _MinBias;
 uniform float _MaxBias;
 uniform int _PCFSamplesSqrRt;
 
-struct Material
-{
-	float Ka;
-	float Kd;
-	float Ks;
-	float Shiny;
-};
-uniform Material _Material;
-
 float ShadowCalculation(vec4 fragPosLightSpace) 
 {
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
@@ -62,15 +52,15 @@ float ShadowCalculation(vec4 fragPosLightSpace)
 void main()
 {
 	vec3 normal = normalize(fs_in.worldNormal);
-	vec3 toLight = -_LightDirection;
+	vec3 toLight = -_LightDirection.xyz;
 	float diffFactor = max(dot(normal, toLight),0.0);
-	vec3 toEye = normalize(_EyePos - fs_in.worldPos);
+	vec3 toEye = normalize(_EyePos.xyz - fs_in.worldPos);
 	vec3 h = normalize(toLight + toEye);
-	float specFactor = pow(max(dot(normal, h), 0.0), _Material.Shiny);
-	vec3 lightColor = (_Material.Kd * diffFactor + _Material.Ks * specFactor) * _LightColor;
+	float specFactor = pow(max(dot(normal, h), 0.0), _Shininess);
+	vec3 lightColor = (_Kd * diffFactor + _Ks * specFactor) * _LightColor;
 	float shadow = ShadowCalculation(fs_in.fragPosLightSpace);
 	lightColor *= (1.0 - shadow);
-	lightColor += _AmbientColor * _Material.Ka;
+	lightColor += _AmbientColor * _Ka;
 	vec3 objColor = texture(_MainTex, fs_in.texCoord).rgb;
 	FragColor = vec4(objColor * lightColor, 1.0);
 }
\ No newline at end of file
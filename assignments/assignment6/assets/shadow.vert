@@ -4,9 +4,12 @@ layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vTexCoord;
 
+#ifdef INSTANCED
+layout(location = 4) in mat4 iModel; // Per instance model matrix, see ew::InstanceBuffer
+#else
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
-uniform mat4 _LightSpaceMatrix;
+#endif
+#include "uniformBlocks.glsl"
 
 out Surface
 {
@@ -18,9 +21,14 @@ out Surface
 
 void main()
 {
-	vs_out.worldPos = vec3(_Model * vec4(vPos, 1.0));
-	vs_out.worldNormal = transpose(inverse(mat3(_Model))) * vNormal;
+#ifdef INSTANCED
+	mat4 model = iModel;
+#else
+	mat4 model = _Model;
+#endif
+	vs_out.worldPos = vec3(model * vec4(vPos, 1.0));
+	vs_out.worldNormal = transpose(inverse(mat3(model))) * vNormal;
 	vs_out.texCoord = vTexCoord;
     vs_out.fragPosLightSpace = _LightSpaceMatrix * vec4(vs_out.worldPos, 1.0);
-	gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
+	gl_Position = _ViewProjection * model * vec4(vPos, 1.0);
 }
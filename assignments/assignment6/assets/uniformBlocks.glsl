@@ -0,0 +1,23 @@
+//Standard uniform blocks. Layouts mirror FrameBlock, ViewBlock and MaterialBlock in ew/uniformBuffer.h,
+//and every ew::Shader links them to their binding points
+layout(std140) uniform _FrameData
+{
+	float _Time;
+	float _DeltaTime;
+	vec4 _LightDirection;
+	mat4 _LightSpaceMatrix;
+};
+layout(std140) uniform _ViewData
+{
+	mat4 _View;
+	mat4 _Projection;
+	mat4 _ViewProjection;
+	vec4 _EyePos;
+};
+layout(std140) uniform _MaterialData
+{
+	float _Ka;
+	float _Kd;
+	float _Ks;
+	float _Shininess;
+};
@@ -5,9 +5,14 @@
 
 #include <ew/external/glad.h>
 #include <ew/shader.h>
+#include <ew/uniformBuffer.h>
+#include <ew/glState.h>
 #include <ew/model.h>
+#include <ew/instanceBuffer.h>
 #include <ew/camera.h>
 #include <ew/transform.h>
+#include <ew/hierarchy.h>
+#include <ew/benchmark.h>
 #include <ew/cameraController.h>
 #include <ew/texture.h>
 #include <ew/procGen.h>
@@ -48,6 +53,11 @@ Material material;
 float minBias = 0.005f;
 float maxBias = 0.05f;
 
+//Skeleton parts left after frustum culling in the main pass
+unsigned int visibleParts = 0;
+
+//Runs on a worker so the sweep doesn't freeze the window
+
 glm::vec3 VecFy(float right[]) 
 {
 	glm::vec3 ret;
@@ -63,107 +73,38 @@ glm::quat EulToQuat(float eul[])
 	return glm::quat(glm::vec3(eul[0], eul[1], eul[2]));
 }
 
-glm::vec3 RotateVec3(glm::vec3 input, glm::quat rotate) 
-{
-	glm::vec3 ret;
-	glm::quat rotNorm = glm::normalize(rotate);
-	glm::vec3 rotVec = glm::vec3(rotNorm.x, rotNorm.y, rotNorm.z);
-	float s = rotate.w;
-	ret = 2.0f * glm::dot(rotVec, input) * rotVec + (s * s - glm::dot(rotVec, rotVec)) * input + 2.0f * s * glm::cross(rotVec, input);
-
-	return ret;
-}
-
+// Euler angles stay here for the UI. The hierarchy holds the local transforms and computes world matrices
 struct ExposureTransform 
 {
 	float pos[3];
 	float rot[3];
 	float sca[3];
-	ExposureTransform* parent;
+	int node;
 };
 
-std::vector<ExposureTransform*> transforms;
+std::vector<ExposureTransform> transforms;
+ew::TransformHierarchy hierarchy;
 
-void addTransform(glm::vec3 pos, glm::vec3 rot, glm::vec3 sca, int parentIndex) 
+void syncTransform(ExposureTransform& t)
 {
-	ExposureTransform* ret = new ExposureTransform;
-	for (int i = 0; i < 3; i++) 
-	{
-		ret->pos[i] = pos[i];
-		ret->rot[i] = rot[i];
-		ret->sca[i] = sca[i];
-	}
-	if (parentIndex == -1) 
-	{
-		ret->parent = nullptr;
-	}
-	else 
-	{
-		ret->parent = transforms[parentIndex];
-	}
-	transforms.push_back(ret);
-}
-
-glm::mat4 localMatrix(ExposureTransform* input)
-{
-	glm::mat4 local = glm::mat4(1.0f);
-	local = glm::translate(local, VecFy(input->pos));
-	local *= glm::toMat4(EulToQuat(input->rot));
-	local = glm::scale(local, VecFy(input->sca));
-
-	if (input->parent != nullptr)
-	{
-		return localMatrix(input->parent) * local;
-	}
-	else
-	{
-		return local;
-	}
-}
-
-
-glm::quat localRot(ExposureTransform* input) 
-{
-	glm::quat ret;
-	if (input->parent != nullptr) 
-	{
-		ret = localRot(input->parent);
-		ret *= EulToQuat(input->rot);
-	}
-	else {
-		ret = EulToQuat(input->rot);
-	}
-	return ret;
+	hierarchy.setLocalPosition(t.node, VecFy(t.pos));
+	hierarchy.setLocalRotation(t.node, EulToQuat(t.rot));
+	hierarchy.setLocalScale(t.node, VecFy(t.sca));
 }
 
-glm::vec3 localPos(ExposureTransform* input) 
-{
-	glm::vec3 ret;
-	if (input->parent != nullptr) 
-	{
-		ret = localPos(input->parent);
-		ret += RotateVec3(VecFy(input->pos), localRot(input->parent));
-	}
-	else 
-	{
-		ret = VecFy(input->pos);
-	}
-	return ret;
-}
-
-glm::vec3 localSca(ExposureTransform* input) 
+void addTransform(glm::vec3 pos, glm::vec3 rot, glm::vec3 sca, int parentIndex) 
 {
-	glm::vec3 ret;
-	if (input->parent != nullptr) 
-	{
-		ret = localSca(input->parent);
-		ret *= VecFy(input->sca);
-	}
-	else 
+	ExposureTransform ret;
+	for (int i = 0; i < 3; i++) 
 	{
-		ret = VecFy(input->sca);
+		ret.pos[i] = pos[i];
+		ret.rot[i] = rot[i];
+		ret.sca[i] = sca[i];
 	}
-	return ret;
+	//Parents are always added first, so node indices line up with transforms
+	ret.node = hierarchy.addNode(parentIndex == -1 ? ew::TransformHierarchy::NO_PARENT : transforms[parentIndex].node);
+	syncTransform(ret);
+	transforms.push_back(ret);
 }
 
 int selectedPart = 0;
@@ -177,16 +118,29 @@ int main()
 	ew::Shader shader = ew::Shader("assets/lit.vert", "assets/lit.frag");
 	ew::Shader shadow = ew::Shader("assets/lighting.vert", "assets/lighting.frag");
 	ew::Shader shaded = ew::Shader("assets/shadow.vert", "assets/shadow.frag");
+	ew::Shader shadowInstanced = ew::Shader("assets/lighting.vert", "assets/lighting.frag", { "INSTANCED" });
+	ew::Shader shadedInstanced = ew::Shader("assets/shadow.vert", "assets/shadow.frag", { "INSTANCED" });
 	ew::Model monkey = ew::Model("assets/suzanne.obj");
 	ew::MeshData planeData = ew::createPlane(50, 50, 1);
 	ew::Mesh plane = ew::Mesh(planeData);
 	ew::MeshData pointLightData = ew::createSphere(0.05f, 20);
 	ew::Mesh pointLight = ew::Mesh(pointLightData);
+	//Skeleton parts are drawn as instances of the monkey, culled against each pass's frustum
+	ew::InstanceBuffer partInstances(ew::InstanceFormat::MAT4);
+	monkey.setInstanceBuffer(&partInstances);
 	ew::Transform monkeyTrans;
 	ew::Transform planeTrans;
 	ew::Transform lightTrans;
 	GLuint brickTexture = ew::loadTexture("assets/brick_color.jpg");
 
+	//Per frame, per view and material data shared by every shader through the standard uniform blocks
+	ew::UniformBuffer<ew::FrameBlock> frameBuffer;
+	ew::UniformBuffer<ew::ViewBlock> cameraViewBuffer;
+	ew::UniformBuffer<ew::ViewBlock> lightViewBuffer;
+	ew::UniformBuffer<ew::MaterialBlock> materialBuffer;
+	frameBuffer.bind(ew::UniformBlockBinding::FRAME);
+	materialBuffer.bind(ew::UniformBlockBinding::MATERIAL);
+
 	cam.position = glm::vec3(0.0f, 0.0f, 5.0f);
 	cam.target = glm::vec3(0.0f, 0.0f, 0.0f);
 	cam.aspectRatio = (float)screenWidth / screenHeight;
@@ -218,20 +172,20 @@ int main()
 
 	planeTrans.position = glm::vec3(0.0f, -10.0f, 0.0f);
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK); //Back face culling
-	glEnable(GL_DEPTH_TEST); //Depth testing
-	glDepthFunc(GL_LESS);
+	ew::GLState::enable(GL_CULL_FACE);
+	ew::GLState::cullFace(GL_BACK); //Back face culling
+	ew::GLState::enable(GL_DEPTH_TEST); //Depth testing
+	ew::GLState::depthFunc(GL_LESS);
 
 	unsigned int fbo;
 	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
 
 	glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	glGenTextures(1, &depthMap);
-	glBindTexture(GL_TEXTURE_2D, depthMap);
+	ew::GLState::bindTexture(GL_TEXTURE_2D, depthMap);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, screenWidth, screenHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -240,13 +194,13 @@ int main()
 	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	glBindTextureUnit(0, brickTexture);
+	ew::GLState::bindTextureUnit(0, brickTexture);
 
 	addTransform(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), -1);
 	addTransform(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.8f), 0);
@@ -267,65 +221,66 @@ int main()
 
 		cam.aspectRatio = (float)screenWidth / screenHeight;
 		camCon.move(window, &cam, deltaTime);
-		shader.setVec3("_EyePos", cam.position);
 
 		light.aspectRatio = (float)screenWidth / screenHeight;
 		light.position = -lightDir;
 		lightTrans.position = -lightDir;
-		shadow.setVec3("_EyePos", light.position);
+
+		ew::FrameBlock frameData;
+		frameData.time = time;
+		frameData.deltaTime = deltaTime;
+		frameData.lightDirection = glm::vec4(glm::normalize(lightDir), 0.0f);
+		frameData.lightSpaceMatrix = light.viewProjectionMatrix();
+		frameBuffer.set(frameData);
+		cameraViewBuffer.set(ew::makeViewBlock(cam));
+		lightViewBuffer.set(ew::makeViewBlock(light));
+		ew::MaterialBlock materialData;
+		materialData.ka = material.Ka;
+		materialData.kd = material.Kd;
+		materialData.ks = material.Ks;
+		materialData.shininess = material.Shiny;
+		materialBuffer.set(materialData);
+
+		//World matrices are shared by both passes
+		hierarchy.updateWorldMatrices();
 
 		// === SHADOW PASS ===
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
 		glViewport(0, 0, screenWidth, screenHeight);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
-		glCullFace(GL_FRONT);
-		shadow.use();
-		shadow.setMat4("_ViewProjection", light.projectionMatrix() * light.viewMatrix());
-		shadow.setFloat("_Material.Ka", material.Ka);
-		shadow.setFloat("_Material.Kd", material.Kd);
-		shadow.setFloat("_Material.Ks", material.Ks);
-		shadow.setFloat("_Material.Shininess", material.Shiny);
-
-		for (auto& t : transforms)
-		{
-			glm::mat4 model = localMatrix(t);
-			shadow.setMat4("_Model", model);
-			monkey.draw();
-		}
+		ew::GLState::cullFace(GL_FRONT);
+		lightViewBuffer.bind(ew::UniformBlockBinding::VIEW);
+		shadowInstanced.use();
+		monkey.drawInstanced(light.frustum(), &partInstances, hierarchy.getWorldMatrices().data(), hierarchy.getNumNodes());
 
+		shadow.use();
 		shadow.setMat4("_Model", planeTrans.modelMatrix());
 		plane.draw();
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glCullFace(GL_BACK);
+		ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+		ew::GLState::cullFace(GL_BACK);
 
 		// === MAIN SCENE PASS ===
 		glViewport(0, 0, screenWidth, screenHeight);
 		glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindTextureUnit(1, depthMap);
-		shaded.use();
-		shaded.setMat4("_ViewProjection", cam.projectionMatrix() * cam.viewMatrix());
-		shaded.setFloat("_Material.Ka", material.Ka);
-		shaded.setFloat("_Material.Kd", material.Kd);
-		shaded.setFloat("_Material.Ks", material.Ks);
-		shaded.setFloat("_Material.Shininess", material.Shiny);
-		shaded.setMat4("_LightSpaceMatrix", light.projectionMatrix() * light.viewMatrix());
-		shaded.setInt("_ShadowMap", 1);
-		shaded.setInt("_MainTex", 0);
-		shaded.setVec3("_ShadowMapDirection", light.position);
-		shaded.setFloat("_MinBias", minBias);
-		shaded.setFloat("_MaxBias", maxBias);
-
-		for (auto& t : transforms)
+		ew::GLState::bindTextureUnit(1, depthMap);
+		cameraViewBuffer.bind(ew::UniformBlockBinding::VIEW);
+		for (const ew::Shader* pass : { &shadedInstanced, &shaded })
 		{
-			glm::mat4 model = localMatrix(t);
-			shaded.setMat4("_Model", model);
-			monkey.draw();
+			pass->setInt("_ShadowMap", 1);
+			pass->setInt("_MainTex", 0);
+			pass->setVec3("_ShadowMapDirection", light.position);
+			pass->setFloat("_MinBias", minBias);
+			pass->setFloat("_MaxBias", maxBias);
 		}
 
+		shadedInstanced.use();
+		visibleParts = monkey.drawInstanced(cam.frustum(), &partInstances, hierarchy.getWorldMatrices().data(), hierarchy.getNumNodes());
+
+		shaded.use();
 		shaded.setMat4("_Model", planeTrans.modelMatrix());
 		plane.draw();
 
@@ -354,14 +309,31 @@ void drawUI()
 
 	ImGui::Begin("Skeleton");
 	ImGui::ListBox("Select Part:", &selectedPart, selectorParts, 8);
+	ImGui::Text("Visible parts: %u / %u", visibleParts, (unsigned int)transforms.size());
+	//Benchmarks print to the console. They run on the UI thread, so rendering pauses and doesn't compete for cores
+	//Serial vs threaded update times for crowds of this skeleton
+	if (ImGui::Button("Benchmark Hierarchy"))
+	{
+		ew::benchmarkHierarchySweep();
+	}
+	//modelMatrix vs scalar and SIMD batched matrix composition times for 100K transforms
+	if (ImGui::Button("Benchmark Transforms"))
+	{
+		ew::printBenchmarkResult(ew::benchmarkTransformBatch());
+	}
 	ImGui::End();
 
 	ImGui::Begin("Inspector");
 	if (ImGui::CollapsingHeader(selectorParts[selectedPart]))
 	{
-		ImGui::DragFloat3("Position", transforms[selectedPart]->pos, 0.1f, -10.0f, 10.0f);
-		ImGui::DragFloat3("Rotation", transforms[selectedPart]->rot, 0.1f, -10.0f, 10.0f);
-		ImGui::DragFloat3("Scale", transforms[selectedPart]->sca, 0.1f, -10.0f, 10.0f);
+		ExposureTransform& t = transforms[selectedPart];
+		bool changed = ImGui::DragFloat3("Position", t.pos, 0.1f, -10.0f, 10.0f);
+		changed |= ImGui::DragFloat3("Rotation", t.rot, 0.1f, -10.0f, 10.0f);
+		changed |= ImGui::DragFloat3("Scale", t.sca, 0.1f, -10.0f, 10.0f);
+		if (changed)
+		{
+			syncTransform(t);
+		}
 	}
 	ImGui::End();
 
@@ -3,10 +3,13 @@
 #include <GLFW/glfw3.h>
 
 #include "ew/shader.h"
+#include "ew/glState.h"
 #include "ew/camera.h"
 #include "ew/texture.h"
 #include "ew/mesh.h"
 #include "ew/model.h"
+#include "ew/assetRegistry.h"
+#include "ew/shaderCompiler.h"
 #include "ew/cameraController.h"
 
 #include "imgui.h"
@@ -40,10 +43,18 @@ Shader* shadowShader, * lightingShader;
 Shader* geometryShader;
 Shader* decalPreviewShader;
 
+// All five programs are compiled in the background. Draws are skipped until every one is ready
+ShaderCompiler* shaderCompiler;
+AsyncShaderHandle shaderPrograms[5];
+bool shadersReady = false;
+bool shaderReportPrinted = false;
+
 Camera camera;
 CameraController cameraController;
-Model* suzanneModel;
-GLuint brickTexture;
+// Models and textures are shared handles owned by the registry, which loads each file once
+AssetRegistry* assetRegistry;
+std::shared_ptr<Model> suzanneModel;
+std::shared_ptr<TextureAsset> brickTexture;
 
 GLuint gBuffer;
 GLuint gPosition, gNormal, gAlbedo;
@@ -69,7 +80,7 @@ struct Decal
 
 std::vector<Decal> decals;
 
-GLuint decalTextures[3]; // Array for 3 decals
+std::shared_ptr<TextureAsset> decalTextures[3]; // Array for 3 decals
 const char* decalNames[] = { "Bullet Hole", "Blood", "Esports" }; // Names for UI
 int selectedDecal = 0; // Selected decal index
 
@@ -90,7 +101,7 @@ void setupShadowFramebuffer()
     glGenFramebuffers(1, &shadowFBO);
     glGenTextures(1, &shadowMap);
 
-    glBindTexture(GL_TEXTURE_2D, shadowMap);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, shadowMap);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -99,11 +110,11 @@ void setupShadowFramebuffer()
     float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
     glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void setupGBuffer()
@@ -114,14 +125,18 @@ void setupGBuffer()
         glDeleteTextures(1, &gPosition);
         glDeleteTextures(1, &gNormal);
         glDeleteTextures(1, &gAlbedo);
+        ew::GLState::framebufferDeleted(gBuffer);
+        ew::GLState::textureDeleted(gPosition);
+        ew::GLState::textureDeleted(gNormal);
+        ew::GLState::textureDeleted(gAlbedo);
     }
 
     glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
 
     // Create Position texture
     glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gPosition);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, gBufferWidth, gBufferHeight, 0, GL_RGB, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -129,7 +144,7 @@ void setupGBuffer()
 
     // Create Normal texture
     glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gNormal);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, gBufferWidth, gBufferHeight, 0, GL_RGB, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -137,7 +152,7 @@ void setupGBuffer()
 
     // Create Albedo texture
     glGenTextures(1, &gAlbedo);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gAlbedo);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, gBufferWidth, gBufferHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -148,7 +163,7 @@ void setupGBuffer()
 
     // Create and attach depth texture
     glGenTextures(1, &gDepth);
-    glBindTexture(GL_TEXTURE_2D, gDepth);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gDepth);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, gBufferWidth, gBufferHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -161,7 +176,7 @@ void setupGBuffer()
         std::cout << "GBuffer not complete!" << std::endl;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
@@ -180,7 +195,7 @@ void setupPlane()
 
     glGenVertexArrays(1, &planeVAO);
     glGenBuffers(1, &planeVBO);
-    glBindVertexArray(planeVAO);
+    ew::GLState::bindVertexArray(planeVAO);
 
     glGenBuffers(1, &planeEBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEBO);
@@ -196,7 +211,7 @@ void setupPlane()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    ew::GLState::bindVertexArray(0);
 }
 
 void renderQuad()
@@ -216,7 +231,7 @@ void renderQuad()
 
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        ew::GLState::bindVertexArray(quadVAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
@@ -228,7 +243,7 @@ void renderQuad()
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     }
 
-    glBindVertexArray(quadVAO);
+    ew::GLState::bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -282,7 +297,7 @@ void setupDecalCube()
 
     glGenVertexArrays(1, &decalVAO);
     glGenBuffers(1, &decalVBO);
-    glBindVertexArray(decalVAO);
+    ew::GLState::bindVertexArray(decalVAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, decalVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
@@ -298,7 +313,7 @@ void computeLightSpaceMatrix()
     lightSpaceMatrix = lightProjection * lightView;
 }
 
-void renderScene(Shader& shader)
+void renderScene(Shader& shader, const ew::Frustum& frustum)
 {
     shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
     shader.setVec3("lightDir", lightDirection);
@@ -307,28 +322,29 @@ void renderScene(Shader& shader)
 
     glm::mat4 model = glm::mat4(1.0f);
     shader.setMat4("model", model);
-    glBindVertexArray(planeVAO);
+    ew::GLState::bindVertexArray(planeVAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
     model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     shader.setMat4("model", model);
-    suzanneModel->draw();
+    suzanneModel->draw(frustum, model);
 }
 
 void renderShadowPass()
 {
     shadowShader->use();
     glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
     glClear(GL_DEPTH_BUFFER_BIT);
-    renderScene(*shadowShader);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Cull against the light's frustum, since objects outside the camera view can still cast shadows into it
+    renderScene(*shadowShader, ew::createFrustum(lightSpaceMatrix));
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void renderLightingPass()
 {
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     lightingShader->use();
@@ -336,20 +352,20 @@ void renderLightingPass()
     lightingShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
     lightingShader->setMat4("projection", camera.projectionMatrix());
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
+    ew::GLState::activeTexture(GL_TEXTURE0);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gPosition);
     lightingShader->setInt("gPosition", 0);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
+    ew::GLState::activeTexture(GL_TEXTURE1);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gNormal);
     lightingShader->setInt("gNormal", 1);
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
+    ew::GLState::activeTexture(GL_TEXTURE2);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gAlbedo);
     lightingShader->setInt("gAlbedo", 2);
 
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, shadowMap);
+    ew::GLState::activeTexture(GL_TEXTURE3);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, shadowMap);
     lightingShader->setInt("shadowMap", 3);
 
     renderQuad();
@@ -361,63 +377,63 @@ void renderLightingPass()
 void renderGeometryPass()
 {
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     geometryShader->use();
     geometryShader->setMat4("view", camera.viewMatrix());
     geometryShader->setMat4("projection", camera.projectionMatrix());
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, brickTexture);
+    ew::GLState::activeTexture(GL_TEXTURE0);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, brickTexture->id);
 
-    renderScene(*geometryShader);
+    renderScene(*geometryShader, camera.frustum());
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void renderDecalPass()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
     GLuint attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
     glDrawBuffers(3, attachments);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
+    ew::GLState::enable(GL_DEPTH_TEST);
+    ew::GLState::depthFunc(GL_LEQUAL);
+    ew::GLState::depthMask(GL_FALSE);
 
     decalShader->use();
     decalShader->setMat4("view", camera.viewMatrix());
     decalShader->setMat4("projection", camera.projectionMatrix());
-    decalShader->setMat4("inverseView", glm::inverse(camera.viewMatrix()));
-    decalShader->setMat4("inverseProjection", glm::inverse(camera.projectionMatrix()));
+    decalShader->setMat4("inverseView", camera.inverseViewMatrix());
+    decalShader->setMat4("inverseProjection", camera.inverseProjectionMatrix());
     decalShader->setVec2("screenSize", glm::vec2(gBufferWidth, gBufferHeight));
     decalShader->setFloat("nearPlane", 0.1f);
     decalShader->setFloat("farPlane", 100.0f);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gDepth);
+    ew::GLState::activeTexture(GL_TEXTURE0);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gDepth);
     decalShader->setInt("depthTex", 0);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
+    ew::GLState::activeTexture(GL_TEXTURE1);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gPosition);
     decalShader->setInt("gPositionTex", 1);
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
+    ew::GLState::activeTexture(GL_TEXTURE2);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gNormal);
     decalShader->setInt("gNormalTex", 2);
 
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
+    ew::GLState::activeTexture(GL_TEXTURE3);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, gAlbedo);
     decalShader->setInt("gAlbedoTex", 3);
 
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, decalTexture);
+    ew::GLState::activeTexture(GL_TEXTURE4);
+    ew::GLState::bindTexture(GL_TEXTURE_2D, decalTexture);
     decalShader->setInt("decalTex", 4);
 
-    glBindVertexArray(decalVAO);
+    ew::GLState::bindVertexArray(decalVAO);
 
     for (auto& decal : decals)
     {
@@ -432,17 +448,16 @@ void renderDecalPass()
         decalShader->setMat4("decalModelInverse", glm::inverse(model));
 
         // Bind the decal's selected texture
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, decalTextures[decal.textureIndex]);
+        ew::GLState::activeTexture(GL_TEXTURE4);
+        ew::GLState::bindTexture(GL_TEXTURE_2D, decalTextures[decal.textureIndex]->id);
         decalShader->setInt("decalTex", 4);
 
-        glBindVertexArray(decalVAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
-    glDepthMask(GL_TRUE);
-    glDepthFunc(GL_LESS);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ew::GLState::depthMask(GL_TRUE);
+    ew::GLState::depthFunc(GL_LESS);
+    ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
@@ -453,13 +468,13 @@ void renderDecalPreviews()
         return;
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glDisable(GL_DEPTH_TEST);
+    ew::GLState::disable(GL_DEPTH_TEST);
 
     decalPreviewShader->use();
     decalPreviewShader->setMat4("view", camera.viewMatrix());
     decalPreviewShader->setMat4("projection", camera.projectionMatrix());
 
-    glBindVertexArray(decalVAO);
+    ew::GLState::bindVertexArray(decalVAO);
 
     for (auto& decal : decals)
     {
@@ -476,10 +491,37 @@ void renderDecalPreviews()
     }
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glEnable(GL_DEPTH_TEST);
+    ew::GLState::enable(GL_DEPTH_TEST);
 }
 
 
+// Finalizes finished programs, and prints the startup timing report once none are pending
+void updateShaders()
+{
+    if (shadersReady)
+        return;
+    shaderCompiler->update();
+    if (shaderCompiler->getNumPending() > 0)
+        return;
+    if (!shaderReportPrinted)
+    {
+        shaderCompiler->printTimingReport();
+        shaderReportPrinted = true;
+    }
+    for (const AsyncShaderHandle& program : shaderPrograms)
+    {
+        // Failed programs already printed their log, and the scene stays undrawn
+        if (!program->isReady())
+            return;
+    }
+    decalShader = shaderPrograms[0]->getShader();
+    decalPreviewShader = shaderPrograms[1]->getShader();
+    geometryShader = shaderPrograms[2]->getShader();
+    lightingShader = shaderPrograms[3]->getShader();
+    shadowShader = shaderPrograms[4]->getShader();
+    shadersReady = true;
+}
+
 void renderGUI()
 {
 
@@ -487,17 +529,34 @@ void renderGUI()
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    computeLightSpaceMatrix();
-    renderShadowPass();
-    renderGeometryPass();
-    renderDecalPass();
-    renderLightingPass();
-    renderDecalPreviews();
+    updateShaders();
+    if (shadersReady)
+    {
+        computeLightSpaceMatrix();
+        renderShadowPass();
+        renderGeometryPass();
+        renderDecalPass();
+        renderLightingPass();
+        renderDecalPreviews();
+    }
+    else
+    {
+        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        ew::GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
 
     ImGui::Begin("Decal Controls");
 
     ImGui::Checkbox("Show Decal Preview", &showDecalPreview);
-    if (showDecalPreview)
+    ew::GLStateCounters glCounters = ew::GLState::getFrameCounters();
+    ImGui::Text("GL state calls: %u issued, %u skipped", glCounters.issued, glCounters.skipped);
+    ImGui::Text("Assets: %u loaded, %.2f MB", (unsigned int)assetRegistry->getAssets().size(), assetRegistry->getGpuBytes() / (1024.0 * 1024.0));
+    if (!shadersReady)
+    {
+        ImGui::Text("Compiling shaders...");
+    }
+    else if (showDecalPreview)
     {
         renderDecalPreviews();
     }
@@ -588,23 +647,26 @@ int main()
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
-    glEnable(GL_DEPTH_TEST);
+    ew::GLState::enable(GL_DEPTH_TEST);
     setupShadowFramebuffer();
     setupGBuffer();
     setupPlane();
     setupDecalCube();
     std::cout << "Decal VAO = " << decalVAO << std::endl;
 
-    decalShader = new Shader("assets/decal.vert", "assets/decal.frag");
-    decalPreviewShader = new Shader("assets/decal_preview.vert", "assets/decal_preview.frag");
-    geometryShader = new Shader("assets/geometry.vert", "assets/geometry.frag");
-    lightingShader = new Shader("assets/lighting.vert", "assets/lighting.frag");
-    shadowShader = new Shader("assets/shadow.vert", "assets/shadow.frag");
-    suzanneModel = new Model("assets/suzanne.obj");
-    brickTexture = ew::loadTexture("assets/brick_color.jpg");
-    decalTextures[0] = ew::loadTexture("assets/bullethole.png");
-    decalTextures[1] = ew::loadTexture("assets/bloodsplatter.png");
-    decalTextures[2] = ew::loadTexture("assets/logo-cc-esports.png");
+    // Submitted together so the driver can compile them in parallel while models and textures load
+    shaderCompiler = new ShaderCompiler();
+    shaderPrograms[0] = shaderCompiler->add("assets/decal.vert", "assets/decal.frag");
+    shaderPrograms[1] = shaderCompiler->add("assets/decal_preview.vert", "assets/decal_preview.frag");
+    shaderPrograms[2] = shaderCompiler->add("assets/geometry.vert", "assets/geometry.frag");
+    shaderPrograms[3] = shaderCompiler->add("assets/lighting.vert", "assets/lighting.frag");
+    shaderPrograms[4] = shaderCompiler->add("assets/shadow.vert", "assets/shadow.frag");
+    assetRegistry = new AssetRegistry();
+    suzanneModel = assetRegistry->loadModel("assets/suzanne.obj");
+    brickTexture = assetRegistry->loadTexture("assets/brick_color.jpg");
+    decalTextures[0] = assetRegistry->loadTexture("assets/bullethole.png");
+    decalTextures[1] = assetRegistry->loadTexture("assets/bloodsplatter.png");
+    decalTextures[2] = assetRegistry->loadTexture("assets/logo-cc-esports.png");
 
     // Initialize camera
     camera.position = (glm::vec3(0.0f, 0.0f, 3.0f));
@@ -644,8 +706,16 @@ int main()
 
         renderGUI();
         glfwSwapBuffers(window);
+        ew::GLState::beginFrame();
     }
 
+    // Release every handle so the registry frees the GL objects while the context still exists
+    suzanneModel.reset();
+    brickTexture.reset();
+    for (std::shared_ptr<TextureAsset>& decalTexture : decalTextures)
+        decalTexture.reset();
+    delete assetRegistry;
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -5,6 +5,8 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <memory>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -30,6 +32,7 @@ namespace dawslib
             : mTime(time), mValue(value), mMethod(method) {}
     };
 
+    // Keys of each track must be sorted by mTime
     struct AnimationClip
     {
         float duration = 0.0f;
@@ -38,17 +41,69 @@ namespace dawslib
         std::vector<Vec3Key> scaleKeys;
     };
 
+    struct ClipHandle
+    {
+        static constexpr uint32_t Invalid = 0xFFFFFFFF;
+        uint32_t index = Invalid;
+
+        bool IsValid() const { return index != Invalid; }
+    };
+
+    // Owns clips so any number of animators can play the same keys without copying them.
+    // Clips are never removed and never move in memory, so handles and clip pointers stay valid for the library's lifetime
+    class ClipLibrary
+    {
+    public:
+        ClipHandle Add(AnimationClip clip)
+        {
+            mClips.emplace_back(new AnimationClip(std::move(clip)));
+            ClipHandle handle;
+            handle.index = static_cast<uint32_t>(mClips.size() - 1);
+            return handle;
+        }
+
+        // Null for invalid handles
+        const AnimationClip* Get(ClipHandle handle) const
+        {
+            return handle.index < mClips.size() ? mClips[handle.index].get() : nullptr;
+        }
+
+        // For authoring tools. Changes are seen by every animator playing the clip, so keys must stay sorted
+        AnimationClip* Edit(ClipHandle handle)
+        {
+            return handle.index < mClips.size() ? mClips[handle.index].get() : nullptr;
+        }
+
+        size_t Size() const { return mClips.size(); }
+
+    private:
+        std::vector<std::unique_ptr<AnimationClip>> mClips;
+    };
+
+    // Playback state of one instance. The clip is shared and not owned, so animators are cheap to copy
     class Animator
     {
     public:
-        AnimationClip* clip;
+        const AnimationClip* clip = nullptr;
         bool isPlaying = false;
         bool isLooping = false;
         float playbackSpeed = 1.0f;
         float playbackTime = 0.0f;
 
-        Animator() : clip(new AnimationClip) {}
-        ~Animator() { delete clip; }
+        // Key index found by the last sample of each track. Playback usually stays in the same
+        // segment or moves to the next one, so most lookups don't need a search
+        mutable size_t positionCursor = 0;
+        mutable size_t rotationCursor = 0;
+        mutable size_t scaleCursor = 0;
+
+        Animator() = default;
+        Animator(const ClipLibrary& library, ClipHandle handle) { SetClip(library, handle); }
+
+        void SetClip(const ClipLibrary& library, ClipHandle handle)
+        {
+            clip = library.Get(handle);
+            positionCursor = rotationCursor = scaleCursor = 0;
+        }
 
         void Update(float dt)
         {
@@ -68,23 +123,49 @@ namespace dawslib
             }
         }
 
+        glm::vec3 GetPosition() const { return clip ? GetValue(clip->positionKeys, glm::vec3(0.0f), playbackTime, positionCursor) : glm::vec3(0.0f); }
+        glm::vec3 GetRotation() const { return clip ? GetValue(clip->rotationKeys, glm::vec3(0.0f), playbackTime, rotationCursor) : glm::vec3(0.0f); }
+        glm::vec3 GetScale() const { return clip ? GetValue(clip->scaleKeys, glm::vec3(1.0f), playbackTime, scaleCursor) : glm::vec3(1.0f); }
+
         glm::vec3 GetValue(const std::vector<Vec3Key>& keyFrames, const glm::vec3& fallBackValue) const
+        {
+            size_t cursor = 0;
+            return GetValue(keyFrames, fallBackValue, playbackTime, cursor);
+        }
+
+        // Samples a track at time. cursor is the track's key index from the previous sample, and is updated
+        static glm::vec3 GetValue(const std::vector<Vec3Key>& keyFrames, const glm::vec3& fallBackValue, float time, size_t& cursor)
         {
             if (keyFrames.empty()) return fallBackValue;
             if (keyFrames.size() == 1) return keyFrames.front().mValue;
 
-            for (size_t i = 1; i < keyFrames.size(); ++i)
+            size_t i = FindKey(keyFrames, time, cursor);
+            cursor = i;
+            if (i == keyFrames.size()) return keyFrames.back().mValue;
+
+            const Vec3Key& prev = keyFrames[i - 1];
+            const Vec3Key& next = keyFrames[i];
+
+            float t = glm::clamp((time - prev.mTime) / (next.mTime - prev.mTime), 0.0f, 1.0f);
+            return Easing(prev.mValue, next.mValue, t, static_cast<EasingMethod>(prev.mMethod));
+        }
+
+        // Index of the first key after index 0 with mTime > time, or keyFrames.size() if there is none.
+        // Checks the cursor's segment and the one after it before falling back to a binary search
+        static size_t FindKey(const std::vector<Vec3Key>& keyFrames, float time, size_t cursor)
+        {
+            const size_t count = keyFrames.size();
+            for (size_t i = cursor; i < cursor + 2 && i < count; ++i)
             {
-                if (keyFrames[i].mTime > playbackTime)
-                {
-                    const Vec3Key& prev = keyFrames[i - 1];
-                    const Vec3Key& next = keyFrames[i];
-
-                    float t = glm::clamp((playbackTime - prev.mTime) / (next.mTime - prev.mTime), 0.0f, 1.0f);
-                    return Easing(prev.mValue, next.mValue, t, static_cast<EasingMethod>(prev.mMethod));
-                }
+                if (i >= 1 && keyFrames[i].mTime > time && (i == 1 || keyFrames[i - 1].mTime <= time))
+                    return i;
             }
-            return keyFrames.back().mValue;
+            if (count >= 2 && cursor == count && keyFrames.back().mTime <= time)
+                return count;
+
+            auto it = std::upper_bound(keyFrames.begin() + 1, keyFrames.end(), time,
+                [](float value, const Vec3Key& key) { return value < key.mTime; });
+            return static_cast<size_t>(it - keyFrames.begin());
         }
 
     private:
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "animation.h"
+#include "animationSystem.h"
+#include "../ew/threadPool.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace dawslib
+{
+    namespace Detail
+    {
+        inline double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        // Animator's key lookup from before it had cursors, copied unchanged as the baseline:
+        // every sample scans the keys from the start
+        struct LinearKeySampler
+        {
+            float playbackTime = 0.0f;
+
+            glm::vec3 GetValue(const std::vector<Vec3Key>& keyFrames, const glm::vec3& fallBackValue) const
+            {
+                if (keyFrames.empty()) return fallBackValue;
+                if (keyFrames.size() == 1) return keyFrames.front().mValue;
+
+                for (size_t i = 1; i < keyFrames.size(); ++i)
+                {
+                    if (keyFrames[i].mTime > playbackTime)
+                    {
+                        const Vec3Key& prev = keyFrames[i - 1];
+                        const Vec3Key& next = keyFrames[i];
+
+                        float t = glm::clamp((playbackTime - prev.mTime) / (next.mTime - prev.mTime), 0.0f, 1.0f);
+                        return Easing(prev.mValue, next.mValue, t, static_cast<EasingMethod>(prev.mMethod));
+                    }
+                }
+                return keyFrames.back().mValue;
+            }
+
+        private:
+            static glm::vec3 Easing(const glm::vec3& a, const glm::vec3& b, float t, EasingMethod method)
+            {
+                switch (method)
+                {
+                case EasingMethod::Lerp: return glm::mix(a, b, t);
+                case EasingMethod::InOutSine: return EaseInOutSine(a, b, t);
+                case EasingMethod::InOutQuart: return EaseInOutQuart(a, b, t);
+                case EasingMethod::InOutBack: return EaseInOutBack(a, b, t);
+                default: return glm::mix(a, b, t);
+                }
+            }
+
+            static glm::vec3 EaseInOutSine(const glm::vec3& a, const glm::vec3& b, float t)
+            {
+                return glm::mix(a, b, -(std::cos(M_PI * t) - 1) / 2.0f);
+            }
+
+            static glm::vec3 EaseInOutQuart(const glm::vec3& a, const glm::vec3& b, float t)
+            {
+                return glm::mix(a, b, t < 0.5f ? 8.0f * t * t * t * t : 1.0f - std::pow(-2.0f * t + 2.0f, 4) / 2.0f);
+            }
+
+            static glm::vec3 EaseInOutBack(const glm::vec3& a, const glm::vec3& b, float t)
+            {
+                constexpr float c1 = 1.70158f;
+                constexpr float c2 = c1 * 1.525f;
+                return glm::mix(a, b, t < 0.5f
+                    ? (std::pow(2.0f * t, 2.0f) * ((c2 + 1.0f) * 2.0f * t - c2)) / 2.0f
+                    : (std::pow(2.0f * t - 2.0f, 2.0f) * ((c2 + 1.0f) * (2.0f * t - 2.0f) + c2) + 2.0f) / 2.0f);
+            }
+        };
+    }
+
+    struct KeyframeBenchmarkResult
+    {
+        unsigned int keyCount = 0;
+        unsigned int samples = 0;
+        double linearNs = 0.0; // Average per sample scanning keys from the start, as Animator::GetValue used to
+        double binaryNs = 0.0; // Average per sample with a binary search at random times
+        double cursorNs = 0.0; // Average per sample with a cached cursor during forward playback
+        bool matchesLinear = false;
+    };
+
+    // Samples one track of keyCount keys, cycling through every easing method
+    inline KeyframeBenchmarkResult BenchmarkKeyframeLookup(unsigned int keyCount, unsigned int samples = 100000)
+    {
+        KeyframeBenchmarkResult result;
+        result.keyCount = keyCount;
+        result.samples = samples;
+        if (keyCount < 2 || samples == 0) return result;
+
+        std::vector<Vec3Key> keys;
+        keys.reserve(keyCount);
+        for (unsigned int i = 0; i < keyCount; ++i)
+            keys.emplace_back(static_cast<float>(i), glm::vec3(std::sin(static_cast<float>(i)), std::cos(static_cast<float>(i)), static_cast<float>(i % 7)), static_cast<int>(i % 4));
+        const float duration = static_cast<float>(keyCount - 1);
+        std::vector<float> times(samples);
+        for (unsigned int i = 0; i < samples; ++i)
+            times[i] = duration * (i + 0.5f) / samples;
+
+        // Forward playback with one cursor for the whole track
+        std::vector<glm::vec3> values(samples);
+        size_t cursor = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < samples; ++i)
+            values[i] = Animator::GetValue(keys, glm::vec3(0.0f), times[i], cursor);
+        result.cursorNs = Detail::ElapsedMs(start) * 1e6 / samples;
+
+        // Times visited out of order, so every sample falls back to the binary search
+        glm::vec3 sum = glm::vec3(0.0f);
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            size_t scratch = 0;
+            sum += Animator::GetValue(keys, glm::vec3(0.0f), times[(i * 7919ull) % samples], scratch);
+        }
+        result.binaryNs = Detail::ElapsedMs(start) * 1e6 / samples;
+
+        // Linear scans are O(keys) per sample, so long clips only time a spread out subset
+        unsigned int stride = static_cast<unsigned int>(std::max<unsigned long long>(1, static_cast<unsigned long long>(keyCount) * samples / 50000000ull));
+        unsigned int linearSamples = 0;
+        Detail::LinearKeySampler linear;
+        result.matchesLinear = true;
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < samples; i += stride)
+        {
+            linear.playbackTime = times[i];
+            glm::vec3 value = linear.GetValue(keys, glm::vec3(0.0f));
+            result.matchesLinear = result.matchesLinear && value == values[i];
+            ++linearSamples;
+        }
+        result.linearNs = Detail::ElapsedMs(start) * 1e6 / linearSamples;
+        // Keeps the binary search loop from being optimized out
+        volatile float sink = sum.x + sum.y + sum.z;
+        (void)sink;
+        return result;
+    }
+
+    inline void PrintBenchmarkResult(const KeyframeBenchmarkResult& result)
+    {
+        printf("Keyframes %u keys (%u samples): linear %.1fns, binary search %.1fns, cursor %.1fns%s\n",
+            result.keyCount, result.samples, result.linearNs, result.binaryNs, result.cursorNs,
+            result.matchesLinear ? "" : " MISMATCH");
+    }
+
+    // Prints BenchmarkKeyframeLookup results for 2 to 100K keys
+    inline void BenchmarkKeyframeLookupSweep(unsigned int samples = 100000)
+    {
+        const unsigned int keyCounts[] = { 2, 10, 100, 1000, 10000, 100000 };
+        for (unsigned int keyCount : keyCounts)
+            PrintBenchmarkResult(BenchmarkKeyframeLookup(keyCount, samples));
+    }
+
+    struct AnimationSystemBenchmarkResult
+    {
+        unsigned int animatorCount = 0;
+        unsigned int threadCount = 0; // Pool workers. The calling thread works too
+        unsigned int frames = 0;
+        double animatorMs = 0.0; // Average per frame updating and sampling one Animator at a time
+        double serialMs = 0.0; // Average per frame for AnimationSystem::Update(dt)
+        double parallelMs = 0.0; // Average per frame for AnimationSystem::Update(dt, pool)
+        float maxError = 0.0f; // Largest difference of any sampled component from Animator, over every frame
+    };
+
+    // Plays animatorCount animators over 8 shared clips that cycle through every easing method,
+    // with a different speed and start time each, as Animators and as two AnimationSystems
+    inline AnimationSystemBenchmarkResult BenchmarkAnimationSystem(unsigned int animatorCount, unsigned int threadCount, unsigned int frames = 20)
+    {
+        AnimationSystemBenchmarkResult result;
+        result.animatorCount = animatorCount;
+        result.threadCount = threadCount;
+        result.frames = frames;
+        if (animatorCount == 0 || threadCount == 0 || frames == 0) return result;
+
+        const unsigned int clipCount = 8;
+        const unsigned int keyCount = 32;
+        ClipLibrary library;
+        std::vector<ClipHandle> handles;
+        for (unsigned int c = 0; c < clipCount; ++c)
+        {
+            AnimationClip clip;
+            clip.duration = static_cast<float>(keyCount - 1);
+            for (unsigned int k = 0; k < keyCount; ++k)
+            {
+                float time = static_cast<float>(k);
+                int method = static_cast<int>((k + c) % 4);
+                float x = static_cast<float>(k * clipCount + c);
+                clip.positionKeys.emplace_back(time, glm::vec3(std::sin(x), std::cos(x), 0.1f * (k % 7)), method);
+                clip.rotationKeys.emplace_back(time, glm::vec3(0.0f, 45.0f * std::sin(0.5f * x), 10.0f * (k % 3)), method);
+                clip.scaleKeys.emplace_back(time, glm::vec3(1.0f + 0.25f * std::cos(x)), method);
+            }
+            handles.push_back(library.Add(std::move(clip)));
+        }
+
+        std::vector<Animator> animators(animatorCount);
+        AnimationSystem serial;
+        AnimationSystem parallel;
+        serial.Reserve(animatorCount);
+        parallel.Reserve(animatorCount);
+        for (unsigned int i = 0; i < animatorCount; ++i)
+        {
+            Animator& animator = animators[i];
+            animator.SetClip(library, handles[i % clipCount]);
+            animator.isPlaying = true;
+            animator.isLooping = true;
+            animator.playbackSpeed = 0.5f + 0.25f * (i % 5);
+            animator.playbackTime = std::fmod(0.37f * i, animator.clip->duration);
+            serial.Add(library, handles[i % clipCount], true, true, animator.playbackSpeed, animator.playbackTime);
+            parallel.Add(library, handles[i % clipCount], true, true, animator.playbackSpeed, animator.playbackTime);
+        }
+
+        std::vector<glm::vec3> positions(animatorCount);
+        std::vector<glm::vec3> rotations(animatorCount);
+        std::vector<glm::vec3> scales(animatorCount);
+        auto maxDifference = [](const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b, float error)
+        {
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                glm::vec3 d = glm::abs(a[i] - b[i]);
+                error = std::max(error, std::max(d.x, std::max(d.y, d.z)));
+            }
+            return error;
+        };
+
+        ew::ThreadPool threadPool(threadCount);
+        const float dt = 1.0f / 60.0f;
+        double animatorMs = 0.0;
+        double serialMs = 0.0;
+        double parallelMs = 0.0;
+        for (unsigned int f = 0; f < frames; ++f)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (unsigned int i = 0; i < animatorCount; ++i)
+            {
+                Animator& animator = animators[i];
+                animator.Update(dt);
+                positions[i] = animator.GetPosition();
+                rotations[i] = animator.GetRotation();
+                scales[i] = animator.GetScale();
+            }
+            animatorMs += Detail::ElapsedMs(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            serial.Update(dt);
+            serialMs += Detail::ElapsedMs(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            parallel.Update(dt, threadPool);
+            parallelMs += Detail::ElapsedMs(start);
+
+            const AnimationSystem* systems[2] = { &serial, &parallel };
+            for (const AnimationSystem* system : systems)
+            {
+                result.maxError = maxDifference(positions, system->GetPositions(), result.maxError);
+                result.maxError = maxDifference(rotations, system->GetRotations(), result.maxError);
+                result.maxError = maxDifference(scales, system->GetScales(), result.maxError);
+            }
+        }
+        result.animatorMs = animatorMs / frames;
+        result.serialMs = serialMs / frames;
+        result.parallelMs = parallelMs / frames;
+        return result;
+    }
+
+    inline void PrintBenchmarkResult(const AnimationSystemBenchmarkResult& result)
+    {
+        printf("Animation %u animators, %u workers (%u frames): Animator %.3fms, system %.3fms (%.2fx), threaded %.3fms (%.2fx), max error %g\n",
+            result.animatorCount, result.threadCount, result.frames, result.animatorMs,
+            result.serialMs, result.serialMs > 0.0 ? result.animatorMs / result.serialMs : 0.0,
+            result.parallelMs, result.parallelMs > 0.0 ? result.animatorMs / result.parallelMs : 0.0,
+            result.maxError);
+    }
+
+    // Prints BenchmarkAnimationSystem results for 1K to 256K animators with one worker per hardware thread
+    inline void BenchmarkAnimationSystemSweep(unsigned int frames = 20)
+    {
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int animatorCount = 1024; animatorCount <= 256 * 1024; animatorCount *= 4)
+            PrintBenchmarkResult(BenchmarkAnimationSystem(animatorCount, threads, frames));
+    }
+}
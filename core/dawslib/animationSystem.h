@@ -0,0 +1,337 @@
+#pragma once
+
+#include "animation.h"
+#include "../ew/simd.h"
+#include "../ew/threadPool.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace dawslib
+{
+    // Easing factors for t in [0, 1], written without branches so loops over them vectorize.
+    // Sine uses a polynomial instead of std::cos and stays within 1e-6 of Animator's curve
+    namespace Ease
+    {
+        constexpr float BackC1 = 1.70158f;
+        constexpr float BackC2 = BackC1 * 1.525f;
+
+        inline float InOutSine(float t)
+        {
+            // -(cos(pi t) - 1) / 2 == (1 + sin(u)) / 2 with u = pi t - pi / 2 in [-pi/2, pi/2]
+            float u = static_cast<float>(M_PI) * t - static_cast<float>(M_PI / 2.0);
+            float u2 = u * u;
+            float s = u * (1.0f + u2 * (-1.0f / 6.0f + u2 * (1.0f / 120.0f + u2 * (-1.0f / 5040.0f
+                + u2 * (1.0f / 362880.0f + u2 * (-1.0f / 39916800.0f))))));
+            return (1.0f + s) * 0.5f;
+        }
+
+        inline float InOutQuart(float t)
+        {
+            float t2 = t * t;
+            float x = 2.0f - 2.0f * t;
+            float x2 = x * x;
+            return t < 0.5f ? 8.0f * t2 * t2 : 1.0f - x2 * x2 * 0.5f;
+        }
+
+        inline float InOutBack(float t)
+        {
+            float x = 2.0f * t;
+            float y = x - 2.0f;
+            float low = x * x * ((BackC2 + 1.0f) * x - BackC2) * 0.5f;
+            float high = (y * y * ((BackC2 + 1.0f) * y + BackC2) + 2.0f) * 0.5f;
+            return t < 0.5f ? low : high;
+        }
+
+#ifdef EW_SSE
+        inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        inline __m128 InOutSine(__m128 t)
+        {
+            __m128 u = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(static_cast<float>(M_PI)), t), _mm_set1_ps(static_cast<float>(M_PI / 2.0)));
+            __m128 u2 = _mm_mul_ps(u, u);
+            __m128 p = _mm_set1_ps(-1.0f / 39916800.0f);
+            p = _mm_add_ps(_mm_mul_ps(p, u2), _mm_set1_ps(1.0f / 362880.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, u2), _mm_set1_ps(-1.0f / 5040.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, u2), _mm_set1_ps(1.0f / 120.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, u2), _mm_set1_ps(-1.0f / 6.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, u2), _mm_set1_ps(1.0f));
+            return _mm_mul_ps(_mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(u, p)), _mm_set1_ps(0.5f));
+        }
+
+        inline __m128 InOutQuart(__m128 t)
+        {
+            __m128 t2 = _mm_mul_ps(t, t);
+            __m128 x = _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(_mm_set1_ps(2.0f), t));
+            __m128 x2 = _mm_mul_ps(x, x);
+            __m128 low = _mm_mul_ps(_mm_set1_ps(8.0f), _mm_mul_ps(t2, t2));
+            __m128 high = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_mul_ps(x2, x2), _mm_set1_ps(0.5f)));
+            return Select(_mm_cmplt_ps(t, _mm_set1_ps(0.5f)), low, high);
+        }
+
+        inline __m128 InOutBack(__m128 t)
+        {
+            const __m128 c2 = _mm_set1_ps(BackC2);
+            const __m128 c3 = _mm_set1_ps(BackC2 + 1.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            __m128 x = _mm_add_ps(t, t);
+            __m128 y = _mm_sub_ps(x, _mm_set1_ps(2.0f));
+            __m128 low = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, x), _mm_sub_ps(_mm_mul_ps(c3, x), c2)), half);
+            __m128 high = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, y), _mm_add_ps(_mm_mul_ps(c3, y), c2)), _mm_set1_ps(2.0f)), half);
+            return Select(_mm_cmplt_ps(t, half), low, high);
+        }
+#endif
+
+        // Replaces every t in the array with curve(t). curve takes a float, and an __m128 when SSE is available
+        template <typename Curve>
+        inline void Apply(float* t, size_t count, Curve curve)
+        {
+            size_t i = 0;
+#ifdef EW_SSE
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(t + i, curve(_mm_loadu_ps(t + i)));
+#endif
+            for (; i < count; ++i)
+                t[i] = curve(t[i]);
+        }
+
+        inline void Apply(EasingMethod method, float* t, size_t count)
+        {
+            switch (method)
+            {
+            case EasingMethod::InOutSine: Apply(t, count, [](auto x) { return InOutSine(x); }); break;
+            case EasingMethod::InOutQuart: Apply(t, count, [](auto x) { return InOutQuart(x); }); break;
+            case EasingMethod::InOutBack: Apply(t, count, [](auto x) { return InOutBack(x); }); break;
+            default: break;
+            }
+        }
+    }
+
+    // Playback state of many animators in parallel arrays. Update advances every animator, then samples every
+    // track in two passes: key lookup queues each segment by easing method, and each queue is eased in one
+    // branch free loop. Results match Animator within float rounding.
+    class AnimationSystem
+    {
+    public:
+        static constexpr size_t NumEasingMethods = 4;
+        // Animators per task in multithreaded updates
+        static constexpr size_t ChunkSize = 2048;
+
+        size_t Add(const ClipLibrary& library, ClipHandle handle, bool playing = true, bool looping = true, float speed = 1.0f, float time = 0.0f)
+        {
+            return Add(library.Get(handle), playing, looping, speed, time);
+        }
+
+        // Returns the new animator's index. The clip must outlive the system or be replaced with SetClip
+        size_t Add(const AnimationClip* clip, bool playing = true, bool looping = true, float speed = 1.0f, float time = 0.0f)
+        {
+            mClips.push_back(clip);
+            mPlaying.push_back(playing ? 1 : 0);
+            mLooping.push_back(looping ? 1 : 0);
+            mSpeeds.push_back(speed);
+            mTimes.push_back(time);
+            for (int track = 0; track < 3; ++track)
+                mCursors[track].push_back(0);
+            mPositions.push_back(glm::vec3(0.0f));
+            mRotations.push_back(glm::vec3(0.0f));
+            mScales.push_back(glm::vec3(1.0f));
+            return mClips.size() - 1;
+        }
+
+        void Reserve(size_t count)
+        {
+            mClips.reserve(count);
+            mPlaying.reserve(count);
+            mLooping.reserve(count);
+            mSpeeds.reserve(count);
+            mTimes.reserve(count);
+            for (int track = 0; track < 3; ++track)
+                mCursors[track].reserve(count);
+            mPositions.reserve(count);
+            mRotations.reserve(count);
+            mScales.reserve(count);
+        }
+
+        void Clear()
+        {
+            mClips.clear();
+            mPlaying.clear();
+            mLooping.clear();
+            mSpeeds.clear();
+            mTimes.clear();
+            for (int track = 0; track < 3; ++track)
+                mCursors[track].clear();
+            mPositions.clear();
+            mRotations.clear();
+            mScales.clear();
+        }
+
+        size_t Size() const { return mClips.size(); }
+
+        void SetClip(size_t i, const AnimationClip* clip)
+        {
+            mClips[i] = clip;
+            for (int track = 0; track < 3; ++track)
+                mCursors[track][i] = 0;
+        }
+        void SetPlaying(size_t i, bool playing) { mPlaying[i] = playing ? 1 : 0; }
+        void SetLooping(size_t i, bool looping) { mLooping[i] = looping ? 1 : 0; }
+        void SetSpeed(size_t i, float speed) { mSpeeds[i] = speed; }
+        void SetTime(size_t i, float time) { mTimes[i] = time; }
+        const AnimationClip* GetClip(size_t i) const { return mClips[i]; }
+        bool IsPlaying(size_t i) const { return mPlaying[i] != 0; }
+        float GetTime(size_t i) const { return mTimes[i]; }
+
+        // Sampled values from the last Update, one per animator
+        const std::vector<glm::vec3>& GetPositions() const { return mPositions; }
+        const std::vector<glm::vec3>& GetRotations() const { return mRotations; }
+        const std::vector<glm::vec3>& GetScales() const { return mScales; }
+
+        // Animators are sampled a chunk at a time so the easing queues stay in cache
+        void Update(float dt)
+        {
+            if (mWork.empty()) mWork.resize(1);
+            const size_t count = Size();
+            for (size_t begin = 0; begin < count; begin += ChunkSize)
+                UpdateRange(begin, std::min(begin + ChunkSize, count), dt, mWork[0]);
+        }
+
+        // Same results as Update(dt), with chunks of animators spread across the pool
+        void Update(float dt, ew::ThreadPool& threadPool)
+        {
+            const size_t count = Size();
+            const size_t numChunks = (count + ChunkSize - 1) / ChunkSize;
+            if (numChunks <= 1)
+            {
+                Update(dt);
+                return;
+            }
+            if (mWork.size() < numChunks) mWork.resize(numChunks);
+            threadPool.parallelFor(numChunks, [&](size_t chunk) {
+                size_t begin = chunk * ChunkSize;
+                UpdateRange(begin, std::min(begin + ChunkSize, count), dt, mWork[chunk]);
+            });
+        }
+
+    private:
+        // Segments waiting to be eased. t is replaced by the eased factor before mixing.
+        // Arrays only grow, and count is the number in use this frame
+        struct SampleQueue
+        {
+            std::vector<float> t;
+            std::vector<glm::vec3> from;
+            std::vector<glm::vec3> to;
+            std::vector<glm::vec3*> out;
+            size_t count = 0;
+
+            void Reset(size_t capacity)
+            {
+                if (t.size() < capacity)
+                {
+                    t.resize(capacity);
+                    from.resize(capacity);
+                    to.resize(capacity);
+                    out.resize(capacity);
+                }
+                count = 0;
+            }
+        };
+
+        // Scratch queues of one thread, reused every frame so updates don't allocate
+        struct Work
+        {
+            SampleQueue queues[NumEasingMethods];
+        };
+
+        void UpdateRange(size_t begin, size_t end, float dt, Work& work)
+        {
+            // Every track of every animator could land in the same queue
+            for (size_t m = 0; m < NumEasingMethods; ++m)
+                work.queues[m].Reset((end - begin) * 3);
+
+            // Same rules as Animator::Update
+            for (size_t i = begin; i < end; ++i)
+            {
+                const AnimationClip* clip = mClips[i];
+                if (!mPlaying[i] || !clip) continue;
+                float time = mTimes[i] + dt * mSpeeds[i];
+                if (time > clip->duration)
+                {
+                    time = mLooping[i] ? 0.0f : clip->duration;
+                    mPlaying[i] = mLooping[i];
+                }
+                else if (time < 0.0f)
+                {
+                    time = mLooping[i] ? clip->duration : 0.0f;
+                    mPlaying[i] = mLooping[i];
+                }
+                mTimes[i] = time;
+            }
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const AnimationClip* clip = mClips[i];
+                if (!clip) continue;
+                const float time = mTimes[i];
+                QueueSample(clip->positionKeys, glm::vec3(0.0f), time, mCursors[0][i], &mPositions[i], work);
+                QueueSample(clip->rotationKeys, glm::vec3(0.0f), time, mCursors[1][i], &mRotations[i], work);
+                QueueSample(clip->scaleKeys, glm::vec3(1.0f), time, mCursors[2][i], &mScales[i], work);
+            }
+
+            for (size_t m = 0; m < NumEasingMethods; ++m)
+            {
+                SampleQueue& queue = work.queues[m];
+                const size_t count = queue.count;
+                Ease::Apply(static_cast<EasingMethod>(m), queue.t.data(), count);
+                for (size_t s = 0; s < count; ++s)
+                    *queue.out[s] = glm::mix(queue.from[s], queue.to[s], queue.t[s]);
+            }
+        }
+
+        // Writes values that need no easing directly, and queues the rest by easing method
+        static void QueueSample(const std::vector<Vec3Key>& keyFrames, const glm::vec3& fallBackValue, float time, size_t& cursor, glm::vec3* out, Work& work)
+        {
+            if (keyFrames.empty())
+            {
+                *out = fallBackValue;
+                return;
+            }
+            if (keyFrames.size() == 1)
+            {
+                *out = keyFrames.front().mValue;
+                return;
+            }
+            size_t i = Animator::FindKey(keyFrames, time, cursor);
+            cursor = i;
+            if (i == keyFrames.size())
+            {
+                *out = keyFrames.back().mValue;
+                return;
+            }
+            const Vec3Key& prev = keyFrames[i - 1];
+            const Vec3Key& next = keyFrames[i];
+            // Unknown methods fall back to Lerp, like Animator
+            size_t method = prev.mMethod >= 0 && prev.mMethod < static_cast<int>(NumEasingMethods) ? static_cast<size_t>(prev.mMethod) : 0;
+            SampleQueue& queue = work.queues[method];
+            const size_t s = queue.count++;
+            queue.t[s] = glm::clamp((time - prev.mTime) / (next.mTime - prev.mTime), 0.0f, 1.0f);
+            queue.from[s] = prev.mValue;
+            queue.to[s] = next.mValue;
+            queue.out[s] = out;
+        }
+
+        std::vector<const AnimationClip*> mClips;
+        std::vector<uint8_t> mPlaying;
+        std::vector<uint8_t> mLooping;
+        std::vector<float> mSpeeds;
+        std::vector<float> mTimes;
+        std::vector<size_t> mCursors[3]; // Position, rotation and scale
+        std::vector<glm::vec3> mPositions;
+        std::vector<glm::vec3> mRotations;
+        std::vector<glm::vec3> mScales;
+        std::vector<Work> mWork;
+    };
+}
@@ -0,0 +1,201 @@
+#include "assetRegistry.h"
+#include "texture.h"
+#include "glState.h"
+#include "external/glad.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#ifndef _WIN32
+#include <limits.h>
+#endif
+
+namespace ew {
+	std::string canonicalPath(const std::string& filePath) {
+#ifdef _WIN32
+		char buffer[_MAX_PATH];
+		std::string path = _fullpath(buffer, filePath.c_str(), _MAX_PATH) ? buffer : filePath;
+		for (size_t i = 0; i < path.size(); i++)
+		{
+			if (path[i] == '\\') {
+				path[i] = '/';
+			}
+			else {
+				path[i] = (char)tolower((unsigned char)path[i]);
+			}
+		}
+		return path;
+#else
+		char buffer[PATH_MAX];
+		return realpath(filePath.c_str(), buffer) ? std::string(buffer) : filePath;
+#endif
+	}
+
+	//Estimates a texture's size from its level 0 dimensions and format
+	static size_t getTextureBytes(unsigned int texture, bool mipmap, int* width, int* height) {
+		int internalFormat = 0;
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+		GLState::bindTexture(GL_TEXTURE_2D, 0);
+		size_t bytesPerPixel = 4;
+		switch (internalFormat) {
+		case GL_RED: case GL_R8: bytesPerPixel = 1; break;
+		case GL_RG: case GL_RG8: bytesPerPixel = 2; break;
+		case GL_RGB: case GL_RGB8: bytesPerPixel = 3; break;
+		default: break;
+		}
+		size_t bytes = (size_t)(*width) * (size_t)(*height) * bytesPerPixel;
+		//A full mip chain adds a third
+		return mipmap ? bytes + bytes / 3 : bytes;
+	}
+
+	AssetRegistry::~AssetRegistry()
+	{
+		//Handles outside the registry keep their assets alive, but GL objects are only freed through unloadUnused
+		unloadUnused();
+	}
+
+	std::shared_ptr<Model> AssetRegistry::loadModel(const std::string& filePath, const ModelLoadOptions& options)
+	{
+		char params[128];
+		snprintf(params, sizeof(params), "|opt%d|fmt%d|split%d|pool%p", (int)options.optimizeMeshes, (int)options.vertexFormat,
+			(int)options.splitLargeMeshes, (void*)options.meshPool);
+		std::string key = canonicalPath(filePath) + params;
+		auto it = m_models.find(key);
+		if (it != m_models.end()) {
+			return it->second.asset;
+		}
+		Entry<Model> entry;
+		entry.asset = std::make_shared<Model>(filePath, options);
+		entry.gpuBytes = entry.asset->getGpuBytes();
+		m_models[key] = entry;
+		enforceBudget();
+		return entry.asset;
+	}
+
+	std::shared_ptr<TextureAsset> AssetRegistry::loadTexture(const std::string& filePath)
+	{
+		return loadTexture(filePath, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, true);
+	}
+
+	std::shared_ptr<TextureAsset> AssetRegistry::loadTexture(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap)
+	{
+		char params[64];
+		snprintf(params, sizeof(params), "|wrap%d|mag%d|min%d|mip%d", wrapMode, magFilter, minFilter, (int)mipmap);
+		std::string key = canonicalPath(filePath) + params;
+		auto it = m_textures.find(key);
+		if (it != m_textures.end()) {
+			return it->second.asset;
+		}
+		Entry<TextureAsset> entry;
+		entry.asset = std::make_shared<TextureAsset>();
+		entry.asset->id = ew::loadTexture(filePath.c_str(), wrapMode, magFilter, minFilter, mipmap);
+		//Failed loads aren't cached, so the next call tries the file again
+		if (entry.asset->id == 0) {
+			return entry.asset;
+		}
+		entry.gpuBytes = getTextureBytes(entry.asset->id, mipmap, &entry.asset->width, &entry.asset->height);
+		m_textures[key] = entry;
+		enforceBudget();
+		return entry.asset;
+	}
+
+	std::shared_ptr<Shader> AssetRegistry::loadShader(const std::string& vertexShader, const std::string& fragmentShader)
+	{
+		std::string key = canonicalPath(vertexShader) + "|" + canonicalPath(fragmentShader);
+		auto it = m_shaders.find(key);
+		if (it != m_shaders.end()) {
+			return it->second.asset;
+		}
+		Entry<Shader> entry;
+		entry.asset = std::make_shared<Shader>(vertexShader, fragmentShader);
+		m_shaders[key] = entry;
+		return entry.asset;
+	}
+
+	size_t AssetRegistry::unloadUnused()
+	{
+		size_t freed = 0;
+		for (auto it = m_models.begin(); it != m_models.end();)
+		{
+			if (it->second.asset.use_count() == 1) {
+				it->second.asset->unload();
+				freed += it->second.gpuBytes;
+				it = m_models.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		for (auto it = m_textures.begin(); it != m_textures.end();)
+		{
+			if (it->second.asset.use_count() == 1) {
+				glDeleteTextures(1, &it->second.asset->id);
+				GLState::textureDeleted(it->second.asset->id);
+				freed += it->second.gpuBytes;
+				it = m_textures.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		for (auto it = m_shaders.begin(); it != m_shaders.end();)
+		{
+			if (it->second.asset.use_count() == 1) {
+				glDeleteProgram(it->second.asset->getId());
+				GLState::programDeleted(it->second.asset->getId());
+				it = m_shaders.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		return freed;
+	}
+
+	size_t AssetRegistry::getGpuBytes() const
+	{
+		size_t bytes = 0;
+		for (auto it = m_models.begin(); it != m_models.end(); ++it)
+		{
+			bytes += it->second.gpuBytes;
+		}
+		for (auto it = m_textures.begin(); it != m_textures.end(); ++it)
+		{
+			bytes += it->second.gpuBytes;
+		}
+		return bytes;
+	}
+
+	std::vector<AssetInfo> AssetRegistry::getAssets() const
+	{
+		std::vector<AssetInfo> assets;
+		assets.reserve(m_models.size() + m_textures.size() + m_shaders.size());
+		for (auto it = m_models.begin(); it != m_models.end(); ++it)
+		{
+			assets.push_back(AssetInfo{ AssetType::MODEL, it->first, it->second.gpuBytes, it->second.asset.use_count() - 1 });
+		}
+		for (auto it = m_textures.begin(); it != m_textures.end(); ++it)
+		{
+			assets.push_back(AssetInfo{ AssetType::TEXTURE, it->first, it->second.gpuBytes, it->second.asset.use_count() - 1 });
+		}
+		for (auto it = m_shaders.begin(); it != m_shaders.end(); ++it)
+		{
+			assets.push_back(AssetInfo{ AssetType::SHADER, it->first, it->second.gpuBytes, it->second.asset.use_count() - 1 });
+		}
+		return assets;
+	}
+
+	void AssetRegistry::enforceBudget()
+	{
+		if (m_memoryBudget == 0 || getGpuBytes() <= m_memoryBudget) {
+			return;
+		}
+		unloadUnused();
+		size_t bytes = getGpuBytes();
+		if (bytes > m_memoryBudget) {
+			printf("AssetRegistry: %zu bytes loaded, over budget of %zu bytes\n", bytes, m_memoryBudget);
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "model.h"
+#include "shader.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ew {
+	//Texture owned by the registry. The GL texture is deleted when the last handle is released and the registry unloads it
+	struct TextureAsset {
+		unsigned int id = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	enum class AssetType {
+		MODEL = 0,
+		TEXTURE = 1,
+		SHADER = 2
+	};
+
+	struct AssetInfo {
+		AssetType type;
+		std::string key; //Canonical path(s) plus load parameters
+		size_t gpuBytes = 0;
+		long useCount = 0; //Handles held outside the registry
+	};
+
+	//Loads models, textures and shaders once per canonical path and load parameters, and hands out shared handles.
+	//Assets stay loaded while any handle is alive. unloadUnused() frees those nobody references anymore.
+	class AssetRegistry {
+	public:
+		~AssetRegistry();
+		std::shared_ptr<Model> loadModel(const std::string& filePath, const ModelLoadOptions& options = ModelLoadOptions());
+		//A failed load returns a texture with id 0 and isn't registered, so a later call retries the file
+		std::shared_ptr<TextureAsset> loadTexture(const std::string& filePath);
+		std::shared_ptr<TextureAsset> loadTexture(const std::string& filePath, int wrapMode, int magFilter, int minFilter, bool mipmap);
+		std::shared_ptr<Shader> loadShader(const std::string& vertexShader, const std::string& fragmentShader);
+
+		//Frees every asset that has no handles outside the registry. Returns the number of GPU bytes freed
+		size_t unloadUnused();
+
+		//0 means no budget. Loading past the budget first unloads unused assets, then warns
+		inline void setMemoryBudget(size_t bytes) { m_memoryBudget = bytes; }
+		inline size_t getMemoryBudget()const { return m_memoryBudget; }
+		size_t getGpuBytes()const;
+		std::vector<AssetInfo> getAssets()const;
+	private:
+		template<typename T>
+		struct Entry {
+			std::shared_ptr<T> asset;
+			size_t gpuBytes = 0;
+		};
+		void enforceBudget();
+
+		std::unordered_map<std::string, Entry<Model>> m_models;
+		std::unordered_map<std::string, Entry<TextureAsset>> m_textures;
+		std::unordered_map<std::string, Entry<Shader>> m_shaders;
+		size_t m_memoryBudget = 0;
+	};
+
+	//Absolute path with resolved . and .. and consistent separators, so different spellings of a path share one asset
+	std::string canonicalPath(const std::string& filePath);
+}
@@ -0,0 +1,79 @@
+#include "asyncModelLoader.h"
+#include <chrono>
+
+namespace ew {
+	AsyncModel::AsyncModel(const std::string& filePath, const ModelLoadOptions& options)
+		: m_filePath(filePath), m_options(options), m_state((int)AsyncLoadState::LOADING)
+	{
+	}
+
+	void AsyncModel::draw(Model* placeholder)
+	{
+		if (isReady()) {
+			m_model.draw();
+		}
+		else if (placeholder) {
+			placeholder->draw();
+		}
+	}
+
+	AsyncModelLoader::AsyncModelLoader(ThreadPool* threadPool)
+		: m_threadPool(threadPool)
+	{
+	}
+
+	/// <summary>
+	/// Starts loading a model in the background
+	/// </summary>
+	/// <returns>Handle to poll and draw. Stays valid even if the loader is destroyed</returns>
+	AsyncModelHandle AsyncModelLoader::load(const std::string& filePath, const ModelLoadOptions& options)
+	{
+		AsyncModelHandle handle = std::make_shared<AsyncModel>(filePath, options);
+		AsyncModel* asyncModel = handle.get();
+		m_threadPool->submit([handle, asyncModel]() {
+			bool loaded = loadModelData(asyncModel->m_filePath, asyncModel->m_options, &asyncModel->m_meshData);
+			//Release publishes m_meshData to the GL thread
+			asyncModel->m_state.store((int)(loaded ? AsyncLoadState::UPLOADING : AsyncLoadState::FAILED), std::memory_order_release);
+		});
+		m_pending.push_back(handle);
+		return handle;
+	}
+
+	void AsyncModelLoader::update(float budgetMs)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		auto elapsedMs = [&start]() {
+			return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+		bool uploadedAny = false;
+		for (size_t i = 0; i < m_pending.size();)
+		{
+			AsyncModel* asyncModel = m_pending[i].get();
+			AsyncLoadState state = asyncModel->getState();
+			if (state == AsyncLoadState::UPLOADING) {
+				while (asyncModel->m_nextUpload < asyncModel->m_meshData.size() && (!uploadedAny || elapsedMs() < budgetMs))
+				{
+					MeshData& meshData = asyncModel->m_meshData[asyncModel->m_nextUpload++];
+					asyncModel->m_model.addMesh(meshData, asyncModel->m_options);
+					//CPU copy is no longer needed once it's on the GPU
+					meshData = MeshData();
+					uploadedAny = true;
+				}
+				if (asyncModel->m_nextUpload == asyncModel->m_meshData.size()) {
+					asyncModel->m_meshData.clear();
+					asyncModel->m_meshData.shrink_to_fit();
+					asyncModel->m_state.store((int)AsyncLoadState::READY, std::memory_order_release);
+					state = AsyncLoadState::READY;
+				}
+			}
+			if (state == AsyncLoadState::READY || state == AsyncLoadState::FAILED) {
+				m_pending.erase(m_pending.begin() + i);
+				continue;
+			}
+			i++;
+			if (uploadedAny && elapsedMs() >= budgetMs) {
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "model.h"
+#include "threadPool.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ew {
+	enum class AsyncLoadState {
+		LOADING = 0, //File is being read and parsed on a worker thread
+		UPLOADING = 1, //Mesh data is in memory and waiting for AsyncModelLoader::update to upload it
+		READY = 2,
+		FAILED = 3
+	};
+
+	//A model that is loaded in the background. Poll isReady() and draw a placeholder until then
+	class AsyncModel {
+	public:
+		AsyncModel(const std::string& filePath, const ModelLoadOptions& options);
+		inline AsyncLoadState getState()const { return (AsyncLoadState)m_state.load(std::memory_order_acquire); }
+		inline bool isReady()const { return getState() == AsyncLoadState::READY; }
+		inline const std::string& getFilePath()const { return m_filePath; }
+		//Only valid once isReady() returns true
+		inline Model& getModel() { return m_model; }
+		//Draws the model if it is ready, otherwise the placeholder if one is given
+		void draw(Model* placeholder = nullptr);
+	private:
+		friend class AsyncModelLoader;
+		std::string m_filePath;
+		ModelLoadOptions m_options;
+		std::atomic<int> m_state;
+		std::vector<MeshData> m_meshData; //Owned by the worker until the state becomes UPLOADING
+		size_t m_nextUpload = 0;
+		Model m_model;
+	};
+
+	typedef std::shared_ptr<AsyncModel> AsyncModelHandle;
+
+	//Parses models on a thread pool and uploads them on the GL thread within a per-frame time budget
+	class AsyncModelLoader {
+	public:
+		AsyncModelLoader(ThreadPool* threadPool = &ThreadPool::getShared());
+		AsyncModelHandle load(const std::string& filePath, const ModelLoadOptions& options = ModelLoadOptions());
+		//Call once per frame on the GL thread. Uploads parsed meshes until budgetMs is spent, at least one mesh per call
+		void update(float budgetMs = 2.0f);
+		inline size_t getNumPending()const { return m_pending.size(); }
+	private:
+		ThreadPool* m_threadPool;
+		std::vector<AsyncModelHandle> m_pending;
+	};
+}
@@ -0,0 +1,169 @@
+#include "batchRenderer.h"
+#include "glState.h"
+#include "external/glad.h"
+#include <algorithm>
+
+namespace ew {
+	BatchRenderer::BatchRenderer(MeshPool* meshPool, unsigned int maxDraws)
+		: m_meshPool(meshPool)
+	{
+		reserve(maxDraws > 0 ? maxDraws : 1);
+	}
+
+	BatchRenderer::~BatchRenderer()
+	{
+		glDeleteBuffers(1, &m_indirectBuffer);
+		glDeleteBuffers(1, &m_transformBuffer);
+		glDeleteBuffers(1, &m_drawIdBuffer);
+	}
+
+	/// <summary>
+	/// (Re)creates GPU buffers large enough for maxDraws draws, and attaches the draw id attribute to the pool's VAO.
+	/// The indirect and transform buffers are only created when the context supports them
+	/// </summary>
+	void BatchRenderer::reserve(unsigned int maxDraws)
+	{
+		if (m_drawIdBuffer == 0) {
+			glGenBuffers(1, &m_drawIdBuffer);
+			if (isIndirectSupported()) {
+				glGenBuffers(1, &m_indirectBuffer);
+				glGenBuffers(1, &m_transformBuffer);
+			}
+		}
+		m_maxDraws = maxDraws;
+
+		if (m_indirectBuffer != 0) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * (size_t)maxDraws, NULL, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_transformBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * (size_t)maxDraws, NULL, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+
+		//Identity sequence read with divisor 1, so each instance sees baseInstance + gl_InstanceID
+		std::vector<unsigned int> drawIds(maxDraws);
+		for (unsigned int i = 0; i < maxDraws; i++)
+		{
+			drawIds[i] = i;
+		}
+		GLState::bindVertexArray(m_meshPool->getVAO());
+		glBindBuffer(GL_ARRAY_BUFFER, m_drawIdBuffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(unsigned int) * drawIds.size(), drawIds.data(), GL_STATIC_DRAW);
+		glVertexAttribIPointer(DRAW_ID_LOCATION, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (const void*)0);
+		glVertexAttribDivisor(DRAW_ID_LOCATION, 1);
+		glEnableVertexAttribArray(DRAW_ID_LOCATION);
+		GLState::bindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_dirty = true;
+	}
+
+	void BatchRenderer::begin()
+	{
+		m_draws.clear();
+		m_dirty = true;
+	}
+
+	void BatchRenderer::submit(MeshPoolHandle mesh, const glm::mat4& model)
+	{
+		m_draws.push_back(DrawRequest{ mesh, model });
+		m_dirty = true;
+	}
+
+	bool BatchRenderer::isIndirectSupported() const
+	{
+		return GLAD_GL_VERSION_4_3 && glMultiDrawElementsIndirect != NULL;
+	}
+
+	std::vector<std::string> BatchRenderer::getShaderDefines() const
+	{
+		if (usesIndirect()) {
+			return { "BATCH_INDIRECT" };
+		}
+		return {};
+	}
+
+	/// <summary>
+	/// Groups submissions by mesh into instanced commands and uploads commands and transforms
+	/// </summary>
+	void BatchRenderer::build()
+	{
+		//Stable so draws of the same mesh keep their submission order
+		std::stable_sort(m_draws.begin(), m_draws.end(), [](const DrawRequest& a, const DrawRequest& b) {
+			return a.mesh.slot < b.mesh.slot;
+		});
+		m_commands.clear();
+		m_transforms.clear();
+		m_transforms.reserve(m_draws.size());
+		for (size_t i = 0; i < m_draws.size(); i++)
+		{
+			const DrawRequest& draw = m_draws[i];
+			if (!m_meshPool->isValid(draw.mesh)) {
+				continue;
+			}
+			bool sameMesh = !m_commands.empty() && i > 0
+				&& m_draws[i - 1].mesh.slot == draw.mesh.slot
+				&& m_draws[i - 1].mesh.generation == draw.mesh.generation;
+			if (sameMesh) {
+				m_commands.back().instanceCount++;
+			}
+			else {
+				const MeshPoolRange& range = m_meshPool->getRange(draw.mesh);
+				DrawElementsIndirectCommand command;
+				command.count = range.numIndices;
+				command.instanceCount = 1;
+				command.firstIndex = range.firstIndex;
+				command.baseVertex = range.baseVertex;
+				command.baseInstance = m_transforms.size();
+				m_commands.push_back(command);
+			}
+			m_transforms.push_back(draw.model);
+		}
+
+		if (m_transforms.size() > m_maxDraws) {
+			reserve(std::max((unsigned int)m_transforms.size(), m_maxDraws * 2));
+		}
+		if (!m_commands.empty() && m_indirectBuffer != 0) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * m_commands.size(), m_commands.data());
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_transformBuffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(glm::mat4) * m_transforms.size(), m_transforms.data());
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+		m_dirty = false;
+	}
+
+	void BatchRenderer::flush(const Shader& shader)
+	{
+		if (m_dirty) {
+			build();
+		}
+		if (m_commands.empty()) {
+			return;
+		}
+		m_meshPool->bind();
+		if (usesIndirect()) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TRANSFORM_BINDING, m_transformBuffer);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)0, m_commands.size(), 0);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
+		else {
+			//Debug path: one draw per instance, with its transform in a uniform
+			constexpr uint32_t MODEL_HASH = uniformHash("_Model");
+			UniformHandle modelUniform = shader.getUniform(MODEL_HASH);
+			for (size_t i = 0; i < m_commands.size(); i++)
+			{
+				const DrawElementsIndirectCommand& command = m_commands[i];
+				for (unsigned int j = 0; j < command.instanceCount; j++)
+				{
+					shader.setMat4(modelUniform, m_transforms[command.baseInstance + j]);
+					glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+						(const void*)(sizeof(unsigned int) * (size_t)command.firstIndex), command.baseVertex);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "meshPool.h"
+#include "shader.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace ew {
+	//Layout matches what glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+	struct DrawElementsIndirectCommand {
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	//Collects draws of MeshPool meshes for a frame and submits them with glMultiDrawElementsIndirect.
+	//Draws of the same mesh are merged into one instanced command.
+	//Model matrices are uploaded to an SSBO. The vertex shader reads its matrix through a per-instance draw id:
+	//	layout(location = 3) in uint _DrawID;
+	//	layout(std430, binding = 0) readonly buffer _Transforms { mat4 _Models[]; };
+	//	mat4 model = _Models[_DrawID];
+	//setUseIndirect(false) switches to a debug path with no SSBO. Each instance is drawn with glDrawElementsBaseVertex
+	//after setting the shader's _Model uniform. It is not a fallback for older contexts: it still needs GL 4.5 like the
+	//rest of ew. Compile the shader with getShaderDefines() to pick the matching path:
+	//	#ifdef BATCH_INDIRECT ...SSBO as above... #else uniform mat4 _Model; #endif
+	class BatchRenderer {
+	public:
+		static const unsigned int TRANSFORM_BINDING = 0;
+		static const unsigned int DRAW_ID_LOCATION = 3;
+
+		BatchRenderer(MeshPool* meshPool, unsigned int maxDraws = 4096);
+		~BatchRenderer();
+		BatchRenderer(const BatchRenderer&) = delete;
+		BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+		//Clears all submitted draws
+		void begin();
+		void submit(MeshPoolHandle mesh, const glm::mat4& model);
+		//Uploads commands and transforms, then draws everything submitted since begin(). The caller binds the shader,
+		//which the debug path uses to set _Model. Submissions are kept, so the same batch can be flushed again for another pass.
+		void flush(const Shader& shader);
+
+		//Indirect drawing is used when supported. Disabling it draws each instance in a loop, to compare against or debug the indirect path
+		inline void setUseIndirect(bool useIndirect) { m_useIndirect = useIndirect; }
+		//GL 4.3, for glMultiDrawElementsIndirect and the transform SSBO
+		bool isIndirectSupported()const;
+		inline bool usesIndirect()const { return m_useIndirect && isIndirectSupported(); }
+		//BATCH_INDIRECT when usesIndirect(), otherwise empty
+		std::vector<std::string> getShaderDefines()const;
+		inline unsigned int getNumSubmitted()const { return m_draws.size(); }
+		inline unsigned int getNumCommands()const { return m_commands.size(); }
+	private:
+		struct DrawRequest {
+			MeshPoolHandle mesh;
+			glm::mat4 model;
+		};
+		void build();
+		void reserve(unsigned int maxDraws);
+
+		MeshPool* m_meshPool;
+		unsigned int m_maxDraws = 0;
+		unsigned int m_indirectBuffer = 0;
+		unsigned int m_transformBuffer = 0;
+		unsigned int m_drawIdBuffer = 0;
+		bool m_useIndirect = true;
+		bool m_dirty = true;
+		std::vector<DrawRequest> m_draws;
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<glm::mat4> m_transforms;
+	};
+}
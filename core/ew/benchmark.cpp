@@ -0,0 +1,251 @@
+#include "benchmark.h"
+#include "instanceBuffer.h"
+#include "hierarchy.h"
+#include "threadPool.h"
+#include "transformBatch.h"
+#include "external/glad.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdio.h>
+
+namespace ew {
+	static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	InstancingBenchmarkResult benchmarkInstancing(const MeshData& meshData, const Shader& individualShader, const Shader& instancedShader, unsigned int instanceCount, unsigned int frames) {
+		InstancingBenchmarkResult result;
+		result.instanceCount = instanceCount;
+		result.frames = frames;
+		if (instanceCount == 0 || frames == 0) {
+			return result;
+		}
+
+		//Lay instances out on a square grid
+		std::vector<glm::mat4> models(instanceCount);
+		unsigned int side = (unsigned int)ceilf(sqrtf((float)instanceCount));
+		for (unsigned int i = 0; i < instanceCount; i++)
+		{
+			glm::vec3 pos = glm::vec3((float)(i % side), 0.0f, (float)(i / side)) * 2.0f;
+			models[i] = glm::translate(glm::mat4(1.0f), pos);
+		}
+		//Own mesh and VAO, so the instance attributes die with the instance buffer
+		Mesh mesh(meshData);
+		InstanceBuffer instanceBuffer(InstanceFormat::MAT4);
+		instanceBuffer.setData(models);
+		mesh.setInstanceBuffer(&instanceBuffer);
+
+		//Warm up both paths so shader compilation and buffer residency aren't measured
+		individualShader.use();
+		individualShader.setMat4("_Model", models[0]);
+		mesh.draw();
+		instancedShader.use();
+		mesh.drawInstanced(instanceCount);
+		glFinish();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		individualShader.use();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			for (unsigned int i = 0; i < instanceCount; i++)
+			{
+				individualShader.setMat4("_Model", models[i]);
+				mesh.draw();
+			}
+			glFinish();
+		}
+		result.individualMs = elapsedMs(start) / frames;
+
+		start = std::chrono::high_resolution_clock::now();
+		instancedShader.use();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			mesh.drawInstanced(instanceCount);
+			glFinish();
+		}
+		result.instancedMs = elapsedMs(start) / frames;
+		mesh.unload();
+		return result;
+	}
+
+	void printBenchmarkResult(const InstancingBenchmarkResult& result) {
+		printf("Instancing x%u (%u frames): individual %.3fms, instanced %.3fms, speedup %.2fx\n",
+			result.instanceCount, result.frames, result.individualMs, result.instancedMs,
+			result.instancedMs > 0.0 ? result.individualMs / result.instancedMs : 0.0);
+	}
+
+	HierarchyBenchmarkResult benchmarkHierarchy(unsigned int nodeCount, unsigned int threadCount, unsigned int iterations) {
+		HierarchyBenchmarkResult result;
+		result.nodeCount = nodeCount;
+		result.threadCount = threadCount;
+		result.iterations = iterations;
+		if (nodeCount == 0 || threadCount == 0 || iterations == 0) {
+			return result;
+		}
+
+		//Body, a 4 joint arm, a 2 joint leg and a head, matching assignment 6
+		const int rigParents[8] = { -1, 0, 1, 2, 3, 0, 5, 0 };
+		const glm::vec3 rigOffsets[8] = {
+			glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+			glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+		};
+		TransformHierarchy serial;
+		TransformHierarchy parallel;
+		serial.reserve(nodeCount);
+		parallel.reserve(nodeCount);
+		std::vector<int> roots;
+		unsigned int side = (unsigned int)ceilf(sqrtf(nodeCount / 8.0f));
+		for (unsigned int i = 0; i < nodeCount; i++)
+		{
+			unsigned int rig = i / 8;
+			unsigned int joint = i % 8;
+			Transform local;
+			local.position = joint == 0 ? glm::vec3((float)(rig % side), 0.0f, (float)(rig / side)) * 3.0f : rigOffsets[joint];
+			local.rotation = glm::quat(glm::vec3(0.1f * joint, 0.01f * rig, 0.0f));
+			local.scale = glm::vec3(joint == 0 ? 1.0f : 0.8f);
+			int parent = rigParents[joint] == -1 ? TransformHierarchy::NO_PARENT : (int)(rig * 8 + rigParents[joint]);
+			serial.addNode(parent, local);
+			parallel.addNode(parent, local);
+			if (joint == 0) {
+				roots.push_back((int)i);
+			}
+		}
+
+		ThreadPool threadPool(threadCount);
+		//First updates build the level lists and warm caches
+		serial.updateWorldMatrices();
+		parallel.updateWorldMatrices(threadPool);
+
+		double serialMs = 0.0;
+		double parallelMs = 0.0;
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			//Dirtying every root recomputes every node, like a fully animated crowd
+			for (int root : roots)
+			{
+				serial.markDirty(root);
+				parallel.markDirty(root);
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+			serial.updateWorldMatrices();
+			serialMs += elapsedMs(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			parallel.updateWorldMatrices(threadPool);
+			parallelMs += elapsedMs(start);
+		}
+		result.serialMs = serialMs / iterations;
+		result.parallelMs = parallelMs / iterations;
+		result.matchesSerial = serial.getChangedNodes() == parallel.getChangedNodes()
+			&& memcmp(serial.getWorldMatrices().data(), parallel.getWorldMatrices().data(), sizeof(glm::mat4) * nodeCount) == 0;
+		return result;
+	}
+
+	void printBenchmarkResult(const HierarchyBenchmarkResult& result) {
+		printf("Hierarchy %u nodes, %u workers (%u updates): serial %.3fms, parallel %.3fms, speedup %.2fx%s\n",
+			result.nodeCount, result.threadCount, result.iterations, result.serialMs, result.parallelMs,
+			result.parallelMs > 0.0 ? result.serialMs / result.parallelMs : 0.0,
+			result.matchesSerial ? "" : " MISMATCH");
+	}
+
+	void benchmarkHierarchySweep(unsigned int iterations) {
+		unsigned int maxThreads = std::thread::hardware_concurrency();
+		if (maxThreads == 0) {
+			maxThreads = 1;
+		}
+		for (unsigned int nodeCount = 1024; nodeCount <= 256 * 1024; nodeCount *= 4)
+		{
+			for (unsigned int threads = 1; ; threads *= 2)
+			{
+				threads = std::min(threads, maxThreads);
+				printBenchmarkResult(benchmarkHierarchy(nodeCount, threads, iterations));
+				if (threads == maxThreads) {
+					break;
+				}
+			}
+		}
+	}
+
+	TransformBatchBenchmarkResult benchmarkTransformBatch(unsigned int transformCount, unsigned int iterations) {
+		TransformBatchBenchmarkResult result;
+		result.transformCount = transformCount;
+		result.iterations = iterations;
+		if (transformCount == 0 || iterations == 0) {
+			return result;
+		}
+
+		std::vector<Transform> transforms(transformCount);
+		TransformSoA soa;
+		soa.resize(transformCount);
+		for (unsigned int i = 0; i < transformCount; i++)
+		{
+			Transform& t = transforms[i];
+			t.position = glm::vec3(sinf(i * 0.1f), cosf(i * 0.3f), (float)(i % 100)) * 10.0f;
+			t.rotation = glm::normalize(glm::quat(glm::vec3(i * 0.01f, i * 0.02f, i * 0.03f)));
+			t.scale = glm::vec3(0.5f + (i % 5) * 0.25f, 1.0f, 0.5f + (i % 3) * 0.5f);
+			soa.set(i, t);
+		}
+		std::vector<glm::mat4> modelMatrices(transformCount);
+		std::vector<glm::mat4> trsMatrices(transformCount);
+		std::vector<glm::mat4> batchMatrices(transformCount);
+		std::vector<Affine3x4> affineMatrices(transformCount);
+
+		//Every path writes its whole output each pass, so the stores can't be optimized out
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int n = 0; n < iterations; n++)
+		{
+			for (unsigned int i = 0; i < transformCount; i++)
+			{
+				modelMatrices[i] = transforms[i].modelMatrix();
+			}
+		}
+		result.modelMatrixMs = elapsedMs(start) / iterations;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int n = 0; n < iterations; n++)
+		{
+			for (unsigned int i = 0; i < transformCount; i++)
+			{
+				const Transform& t = transforms[i];
+				trsMatrices[i] = composeTRS(t.position, t.rotation, t.scale);
+			}
+		}
+		result.composeTRSMs = elapsedMs(start) / iterations;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int n = 0; n < iterations; n++)
+		{
+			composeMatrices(soa, batchMatrices.data());
+		}
+		result.composeMatricesMs = elapsedMs(start) / iterations;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int n = 0; n < iterations; n++)
+		{
+			composeAffineMatrices(soa, affineMatrices.data());
+		}
+		result.composeAffineMs = elapsedMs(start) / iterations;
+
+		const size_t bytes = sizeof(glm::mat4) * transformCount;
+		result.matchesModelMatrix = memcmp(modelMatrices.data(), trsMatrices.data(), bytes) == 0
+			&& memcmp(modelMatrices.data(), batchMatrices.data(), bytes) == 0;
+		for (unsigned int i = 0; i < transformCount && result.matchesModelMatrix; i++)
+		{
+			Affine3x4 expected = toAffine3x4(modelMatrices[i]);
+			result.matchesModelMatrix = memcmp(&expected, &affineMatrices[i], sizeof(Affine3x4)) == 0;
+		}
+		return result;
+	}
+
+	void printBenchmarkResult(const TransformBatchBenchmarkResult& result) {
+		printf("Transforms x%u (%u passes): modelMatrix %.3fms, composeTRS %.3fms, composeMatrices %.3fms (%.2fx), composeAffineMatrices %.3fms (%.2fx)%s\n",
+			result.transformCount, result.iterations, result.modelMatrixMs, result.composeTRSMs,
+			result.composeMatricesMs, result.composeMatricesMs > 0.0 ? result.modelMatrixMs / result.composeMatricesMs : 0.0,
+			result.composeAffineMs, result.composeAffineMs > 0.0 ? result.modelMatrixMs / result.composeAffineMs : 0.0,
+			result.matchesModelMatrix ? "" : " MISMATCH");
+	}
+}
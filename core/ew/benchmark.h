@@ -0,0 +1,48 @@
+#pragma once
+#include "mesh.h"
+#include "shader.h"
+
+namespace ew {
+	struct InstancingBenchmarkResult {
+		unsigned int instanceCount = 0;
+		unsigned int frames = 0;
+		double individualMs = 0.0; //Average per frame for N draw calls with a _Model uniform each
+		double instancedMs = 0.0; //Average per frame for one instanced draw call
+	};
+
+	//Draws the mesh N times per frame both ways, with glFinish after each frame so GPU time is included.
+	//individualShader reads uniform mat4 _Model. instancedShader reads a MAT4 instance attribute (see instanceBuffer.h).
+	//The benchmark uploads its own copy of the mesh, so no caller VAO is left pointing at its instance buffer.
+	InstancingBenchmarkResult benchmarkInstancing(const MeshData& meshData, const Shader& individualShader, const Shader& instancedShader, unsigned int instanceCount, unsigned int frames = 100);
+	void printBenchmarkResult(const InstancingBenchmarkResult& result);
+
+	struct HierarchyBenchmarkResult {
+		unsigned int nodeCount = 0;
+		unsigned int threadCount = 0; //Pool workers. The calling thread works too
+		unsigned int iterations = 0;
+		double serialMs = 0.0; //Average per full update on one thread
+		double parallelMs = 0.0; //Average per full update split by depth level across the pool
+		bool matchesSerial = false; //Every world matrix is bitwise equal between the two
+	};
+
+	//Builds a crowd of 8 node rigs shaped like the assignment 6 skeleton and times full TransformHierarchy updates
+	//serially and with a pool of threadCount workers. No GL calls are made.
+	HierarchyBenchmarkResult benchmarkHierarchy(unsigned int nodeCount, unsigned int threadCount, unsigned int iterations = 50);
+	void printBenchmarkResult(const HierarchyBenchmarkResult& result);
+	//Prints benchmarkHierarchy results for 1K to 256K nodes with 1 worker up to one per hardware thread
+	void benchmarkHierarchySweep(unsigned int iterations = 50);
+
+	struct TransformBatchBenchmarkResult {
+		unsigned int transformCount = 0;
+		unsigned int iterations = 0;
+		double modelMatrixMs = 0.0; //Average per pass calling Transform::modelMatrix for each transform
+		double composeTRSMs = 0.0; //Average per pass calling scalar composeTRS for each transform
+		double composeMatricesMs = 0.0; //Average per pass through the SIMD composeMatrices
+		double composeAffineMs = 0.0; //Average per pass through the SIMD composeAffineMatrices
+		bool matchesModelMatrix = false; //Every path is bitwise equal to Transform::modelMatrix
+	};
+
+	//Composes transformCount random transforms into matrices with each of the paths in transformBatch.h. No GL calls are made.
+	TransformBatchBenchmarkResult benchmarkTransformBatch(unsigned int transformCount = 100000, unsigned int iterations = 50);
+	void printBenchmarkResult(const TransformBatchBenchmarkResult& result);
+}
@@ -0,0 +1,95 @@
+#include "bounds.h"
+#include <cmath>
+
+namespace ew {
+	/// <summary>
+	/// Computes an AABB and a bounding sphere centered on it. The radius is the distance to the farthest point,
+	/// which is tighter than the box's half diagonal
+	/// </summary>
+	Bounds computeBounds(const glm::vec3* positions, size_t count, size_t stride) {
+		Bounds bounds;
+		const unsigned char* bytes = (const unsigned char*)positions;
+		for (size_t i = 0; i < count; i++)
+		{
+			bounds.aabb.add(*(const glm::vec3*)(bytes + i * stride));
+		}
+		if (count == 0) {
+			return bounds;
+		}
+		glm::vec3 center = bounds.aabb.getCenter();
+		float radiusSquared = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::vec3 d = *(const glm::vec3*)(bytes + i * stride) - center;
+			radiusSquared = std::fmax(radiusSquared, glm::dot(d, d));
+		}
+		bounds.sphere.center = center;
+		bounds.sphere.radius = std::sqrt(radiusSquared);
+		return bounds;
+	}
+
+	BoundingSphere getBoundingSphere(const AABB& aabb) {
+		BoundingSphere sphere;
+		if (aabb.isValid()) {
+			sphere.center = aabb.getCenter();
+			sphere.radius = glm::length(aabb.getExtents());
+		}
+		return sphere;
+	}
+
+	AABB transformAABB(const AABB& aabb, const glm::mat4& m) {
+		if (!aabb.isValid()) {
+			return aabb;
+		}
+		glm::vec3 center = glm::vec3(m * glm::vec4(aabb.getCenter(), 1.0f));
+		glm::vec3 extents = aabb.getExtents();
+		glm::vec3 newExtents = glm::abs(glm::vec3(m[0])) * extents.x
+			+ glm::abs(glm::vec3(m[1])) * extents.y
+			+ glm::abs(glm::vec3(m[2])) * extents.z;
+		AABB result;
+		result.min = center - newExtents;
+		result.max = center + newExtents;
+		return result;
+	}
+
+	BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& m) {
+		if (!sphere.isValid()) {
+			return sphere;
+		}
+		float scaleSquared = std::fmax(glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+			std::fmax(glm::dot(glm::vec3(m[1]), glm::vec3(m[1])), glm::dot(glm::vec3(m[2]), glm::vec3(m[2]))));
+		BoundingSphere result;
+		result.center = glm::vec3(m * glm::vec4(sphere.center, 1.0f));
+		result.radius = sphere.radius * std::sqrt(scaleSquared);
+		return result;
+	}
+
+	/// <summary>
+	/// Merges two bounds. The sphere is rebuilt to enclose both spheres
+	/// </summary>
+	Bounds mergeBounds(const Bounds& a, const Bounds& b) {
+		if (!a.aabb.isValid()) {
+			return b;
+		}
+		if (!b.aabb.isValid()) {
+			return a;
+		}
+		Bounds result;
+		result.aabb = a.aabb;
+		result.aabb.add(b.aabb);
+		glm::vec3 d = b.sphere.center - a.sphere.center;
+		float distance = glm::length(d);
+		if (distance + b.sphere.radius <= a.sphere.radius) {
+			result.sphere = a.sphere;
+		}
+		else if (distance + a.sphere.radius <= b.sphere.radius) {
+			result.sphere = b.sphere;
+		}
+		else {
+			float radius = (distance + a.sphere.radius + b.sphere.radius) * 0.5f;
+			result.sphere.center = a.sphere.center + d * ((radius - a.sphere.radius) / distance);
+			result.sphere.radius = radius;
+		}
+		return result;
+	}
+}
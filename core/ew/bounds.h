@@ -0,0 +1,39 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <stddef.h>
+#include <cfloat>
+
+namespace ew {
+	//Axis aligned bounding box. Empty (min > max) until a point is added
+	struct AABB {
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+		inline bool isValid()const { return min.x <= max.x; }
+		inline glm::vec3 getCenter()const { return (min + max) * 0.5f; }
+		inline glm::vec3 getExtents()const { return (max - min) * 0.5f; }
+		inline void add(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+		inline void add(const AABB& b) { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+	};
+
+	//Layout is vec4 compatible (center xyz, radius w), so arrays can be loaded straight into SIMD registers
+	struct BoundingSphere {
+		glm::vec3 center = glm::vec3(0.0f);
+		float radius = -1.0f; //Negative when empty
+		inline bool isValid()const { return radius >= 0.0f; }
+	};
+
+	struct Bounds {
+		AABB aabb;
+		BoundingSphere sphere;
+	};
+
+	//Bounds of a set of points. stride is the distance in bytes between positions, e.g. sizeof(Vertex)
+	Bounds computeBounds(const glm::vec3* positions, size_t count, size_t stride = sizeof(glm::vec3));
+	//Sphere around a box, for bounds built from analytic extents
+	BoundingSphere getBoundingSphere(const AABB& aabb);
+	//Box containing the transformed box (Arvo's method)
+	AABB transformAABB(const AABB& aabb, const glm::mat4& m);
+	//Sphere containing the transformed sphere. The radius is scaled by the largest axis scale
+	BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& m);
+	Bounds mergeBounds(const Bounds& a, const Bounds& b);
+}
@@ -3,10 +3,13 @@
 */
 
 #pragma once
+#include "frustum.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace ew {
+	//Matrices and frustum are cached. Each getter compares the fields it depends on with the values it was last built from,
+	//and only recomputes on a change, so fields can still be written directly. Getters are not safe to call from several threads at once.
 	struct Camera {
 		glm::vec3 position = glm::vec3(0.0f, 0.0f, 5.0f);
 		glm::vec3 target = glm::vec3(0.0f);
@@ -18,30 +21,133 @@ namespace ew {
 		float orthoHeight = 6.0f;
 		float aspectRatio = 1.77f;
 
-		inline glm::mat4 viewMatrix()const {
+		inline const glm::mat4& viewMatrix()const {
+			updateView();
+			return m_view;
+		}
+		inline const glm::mat4& projectionMatrix()const {
+			updateProjection();
+			return m_projection;
+		}
+		inline const glm::mat4& viewProjectionMatrix()const {
+			updateViewProjection();
+			return m_viewProjection;
+		}
+		inline const glm::mat4& inverseViewMatrix()const {
+			updateView();
+			if (!m_inverseViewValid) {
+				m_inverseView = glm::inverse(m_view);
+				m_inverseViewValid = true;
+			}
+			return m_inverseView;
+		}
+		inline const glm::mat4& inverseProjectionMatrix()const {
+			updateProjection();
+			if (!m_inverseProjectionValid) {
+				m_inverseProjection = glm::inverse(m_projection);
+				m_inverseProjectionValid = true;
+			}
+			return m_inverseProjection;
+		}
+		inline const glm::mat4& inverseViewProjectionMatrix()const {
+			updateViewProjection();
+			if (!m_inverseViewProjectionValid) {
+				m_inverseViewProjection = glm::inverse(m_viewProjection);
+				m_inverseViewProjectionValid = true;
+			}
+			return m_inverseViewProjection;
+		}
+		//World space frustum of the camera. See frustum.h
+		inline const Frustum& frustum()const {
+			updateViewProjection();
+			if (!m_frustumValid) {
+				m_frustum = createFrustum(m_viewProjection);
+				m_frustumValid = true;
+			}
+			return m_frustum;
+		}
+	private:
+		//Rebuilds the view matrix if position or target changed since it was last built
+		inline void updateView()const {
+			if (m_viewValid && m_viewPosition == position && m_viewTarget == target) {
+				return;
+			}
 			glm::vec3 toTarget = glm::normalize(target - position);
 			glm::vec3 up = glm::vec3(0, 1, 0);
 			//If camera is aligned with up vector, choose a new one
 			if (glm::abs(glm::dot(toTarget, up)) >= 1.0f - glm::epsilon<float>()) {
 				up = glm::vec3(0, 0, 1);
 			}
-			return glm::lookAt(position, target, up);
+			m_view = glm::lookAt(position, target, up);
+			m_viewPosition = position;
+			m_viewTarget = target;
+			m_viewValid = true;
+			m_inverseViewValid = false;
+			m_viewProjectionValid = false;
 		}
-		inline glm::mat4 projectionMatrix()const {
-
+		inline void updateProjection()const {
+			if (m_projectionValid && m_projectionFov == fov && m_projectionNear == nearPlane && m_projectionFar == farPlane
+				&& m_projectionOrthographic == orthographic && m_projectionOrthoHeight == orthoHeight && m_projectionAspect == aspectRatio) {
+				return;
+			}
 			if (orthographic) {
-				
+
 				float width = orthoHeight * aspectRatio;
 				float r = width / 2;
 				float l = -r;
 				float t = orthoHeight / 2;
 				float b = -t;
-				return glm::ortho(l, r, b, t, nearPlane, farPlane);
+				m_projection = glm::ortho(l, r, b, t, nearPlane, farPlane);
 			}
 			else {
-				return glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
+				m_projection = glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
 			}
+			m_projectionFov = fov;
+			m_projectionNear = nearPlane;
+			m_projectionFar = farPlane;
+			m_projectionOrthographic = orthographic;
+			m_projectionOrthoHeight = orthoHeight;
+			m_projectionAspect = aspectRatio;
+			m_projectionValid = true;
+			m_inverseProjectionValid = false;
+			m_viewProjectionValid = false;
 		}
+		inline void updateViewProjection()const {
+			updateView();
+			updateProjection();
+			if (m_viewProjectionValid) {
+				return;
+			}
+			m_viewProjection = m_projection * m_view;
+			m_viewProjectionValid = true;
+			m_inverseViewProjectionValid = false;
+			m_frustumValid = false;
+		}
+
+		//Field values the cached matrices were built from
+		mutable glm::vec3 m_viewPosition;
+		mutable glm::vec3 m_viewTarget;
+		mutable float m_projectionFov = 0.0f;
+		mutable float m_projectionNear = 0.0f;
+		mutable float m_projectionFar = 0.0f;
+		mutable bool m_projectionOrthographic = false;
+		mutable float m_projectionOrthoHeight = 0.0f;
+		mutable float m_projectionAspect = 0.0f;
+
+		mutable glm::mat4 m_view;
+		mutable glm::mat4 m_projection;
+		mutable glm::mat4 m_viewProjection;
+		mutable glm::mat4 m_inverseView;
+		mutable glm::mat4 m_inverseProjection;
+		mutable glm::mat4 m_inverseViewProjection;
+		mutable Frustum m_frustum;
+		mutable bool m_viewValid = false;
+		mutable bool m_projectionValid = false;
+		mutable bool m_viewProjectionValid = false;
+		mutable bool m_inverseViewValid = false;
+		mutable bool m_inverseProjectionValid = false;
+		mutable bool m_inverseViewProjectionValid = false;
+		mutable bool m_frustumValid = false;
 	};
 
 }
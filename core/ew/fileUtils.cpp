@@ -0,0 +1,22 @@
+#include "fileUtils.h"
+#include <atomic>
+#include <thread>
+#include <functional>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ew {
+	std::string getTempFilePath(const std::string& filePath) {
+		static std::atomic<unsigned int> counter(0);
+#ifdef _WIN32
+		unsigned long processId = (unsigned long)_getpid();
+#else
+		unsigned long processId = (unsigned long)getpid();
+#endif
+		size_t threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+		return filePath + "." + std::to_string(processId) + "." + std::to_string(threadId) + "." + std::to_string(counter++) + ".tmp";
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+
+namespace ew {
+	//Temporary path next to filePath for write-then-rename. Unique per process, thread and call, so concurrent writers
+	//of the same file never share a temporary
+	std::string getTempFilePath(const std::string& filePath);
+}
@@ -0,0 +1,132 @@
+#include "frustum.h"
+#include "simd.h"
+#include <cmath>
+
+namespace ew {
+	static_assert(sizeof(BoundingSphere) == 4 * sizeof(float), "cullSpheres loads spheres as vec4s");
+
+	Frustum createFrustum(const glm::mat4& viewProjection) {
+		//Rows of the matrix. glm is column major, so row i is m[0][i], m[1][i], ...
+		const glm::mat4& m = viewProjection;
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+		}
+		Frustum frustum;
+		frustum.planes[0] = rows[3] + rows[0]; //Left
+		frustum.planes[1] = rows[3] - rows[0]; //Right
+		frustum.planes[2] = rows[3] + rows[1]; //Bottom
+		frustum.planes[3] = rows[3] - rows[1]; //Top
+		frustum.planes[4] = rows[3] + rows[2]; //Near, for -1 to 1 clip space depth
+		frustum.planes[5] = rows[3] - rows[2]; //Far
+		for (int i = 0; i < 6; i++)
+		{
+			float length = glm::length(glm::vec3(frustum.planes[i]));
+			if (length > 0.0f) {
+				frustum.planes[i] /= length;
+			}
+		}
+		return frustum;
+	}
+
+	bool isVisible(const Frustum& frustum, const BoundingSphere& sphere) {
+		if (!sphere.isValid()) {
+			return true;
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			const glm::vec4& plane = frustum.planes[i];
+			if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Tests the box corner farthest along each plane normal. If that corner is outside, the whole box is
+	/// </summary>
+	bool isVisible(const Frustum& frustum, const AABB& aabb) {
+		if (!aabb.isValid()) {
+			return true;
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			const glm::vec4& plane = frustum.planes[i];
+			glm::vec3 corner = glm::vec3(
+				plane.x >= 0.0f ? aabb.max.x : aabb.min.x,
+				plane.y >= 0.0f ? aabb.max.y : aabb.min.y,
+				plane.z >= 0.0f ? aabb.max.z : aabb.min.z);
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t cullSpheres(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint8_t* visible) {
+		size_t numVisible = 0;
+		size_t i = 0;
+#ifdef EW_SSE
+		//Planes broadcast once, so each iteration is 6 x (3 mul + 3 add + cmp) for 4 spheres
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+			planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+			planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+			planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+		}
+		const __m128 zero = _mm_setzero_ps();
+		const float* data = (const float*)spheres;
+		for (; i + 4 <= count; i += 4)
+		{
+			//Load 4 spheres as rows and transpose to x, y, z, radius columns
+			__m128 x = _mm_loadu_ps(data + i * 4);
+			__m128 y = _mm_loadu_ps(data + i * 4 + 4);
+			__m128 z = _mm_loadu_ps(data + i * 4 + 8);
+			__m128 r = _mm_loadu_ps(data + i * 4 + 12);
+			_MM_TRANSPOSE4_PS(x, y, z, r);
+			//Invalid spheres (negative radius) are always visible
+			__m128 inside = _mm_cmplt_ps(r, zero);
+			__m128 allInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+					_mm_add_ps(_mm_mul_ps(planeZ[p], z), _mm_add_ps(planeW[p], r)));
+				allInside = _mm_and_ps(allInside, _mm_cmpge_ps(d, zero));
+			}
+			int mask = _mm_movemask_ps(_mm_or_ps(inside, allInside));
+			for (int k = 0; k < 4; k++)
+			{
+				visible[i + k] = (mask >> k) & 1;
+				numVisible += visible[i + k];
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			visible[i] = isVisible(frustum, spheres[i]) ? 1 : 0;
+			numVisible += visible[i];
+		}
+		return numVisible;
+	}
+
+	size_t cullInstances(const Frustum& frustum, const BoundingSphere& localSphere, const glm::mat4* models, size_t count, uint8_t* visible) {
+		//Transform in fixed size chunks so large batches need no allocation
+		const size_t CHUNK_SIZE = 256;
+		BoundingSphere worldSpheres[CHUNK_SIZE];
+		size_t numVisible = 0;
+		for (size_t start = 0; start < count; start += CHUNK_SIZE)
+		{
+			size_t chunkCount = count - start < CHUNK_SIZE ? count - start : CHUNK_SIZE;
+			for (size_t i = 0; i < chunkCount; i++)
+			{
+				worldSpheres[i] = transformSphere(localSphere, models[start + i]);
+			}
+			numVisible += cullSpheres(frustum, worldSpheres, chunkCount, visible + start);
+		}
+		return numVisible;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "bounds.h"
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+namespace ew {
+	//Six planes with inward facing normals, in the order left, right, bottom, top, near, far.
+	//A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+	struct Frustum {
+		glm::vec4 planes[6];
+	};
+
+	//Extracts normalized planes from a projection * view matrix (Gribb/Hartmann). Planes are in world space,
+	//or in the space the matrix transforms from
+	Frustum createFrustum(const glm::mat4& viewProjection);
+	//Conservative tests. Objects crossing a plane count as visible. Invalid bounds are always visible
+	bool isVisible(const Frustum& frustum, const BoundingSphere& sphere);
+	bool isVisible(const Frustum& frustum, const AABB& aabb);
+
+	//Tests many spheres at once, 4 per iteration with SSE. Writes 1 to visible[i] if spheres[i] is visible, otherwise 0
+	//Returns the number of visible spheres
+	size_t cullSpheres(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint8_t* visible);
+	//Culls instances of one mesh. localSphere is the mesh's bounds, transformed by each model matrix before testing
+	size_t cullInstances(const Frustum& frustum, const BoundingSphere& localSphere, const glm::mat4* models, size_t count, uint8_t* visible);
+}
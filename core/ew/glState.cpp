@@ -0,0 +1,282 @@
+#include "glState.h"
+#include "external/glad.h"
+
+namespace ew {
+	//Value for state that hasn't been set through GLState yet, so the next call is always issued
+	static const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+	enum class Capability {
+		DEPTH_TEST = 0,
+		CULL_FACE = 1,
+		BLEND = 2,
+		STENCIL_TEST = 3,
+		SCISSOR_TEST = 4,
+		COUNT = 5
+	};
+
+	struct TextureBinding {
+		unsigned int target; //0 when bound with bindTextureUnit
+		unsigned int texture;
+	};
+
+	struct StateCache {
+		unsigned int program;
+		unsigned int vao;
+		unsigned int drawFramebuffer;
+		unsigned int readFramebuffer;
+		unsigned int activeUnit; //Index, not GL_TEXTURE0 + i
+		TextureBinding textures[GLState::MAX_TEXTURE_UNITS];
+		unsigned int capabilities[(int)Capability::COUNT]; //UNKNOWN, 0 or 1
+		unsigned int blendSrc, blendDst;
+		unsigned int cullFaceMode;
+		unsigned int depthFuncValue;
+		unsigned int depthMaskValue;
+	};
+
+	static StateCache s_state;
+	static GLStateCounters s_counters;
+	static GLStateCounters s_frameCounters;
+	static bool s_initialized = false;
+
+	static StateCache& getState() {
+		if (!s_initialized) {
+			GLState::invalidate();
+		}
+		return s_state;
+	}
+
+	/// <summary>
+	/// Stores a new value for a piece of state
+	/// </summary>
+	/// <returns>True if the value changed and the GL call must be issued</returns>
+	static bool update(unsigned int& cached, unsigned int value) {
+		if (cached == value) {
+			s_counters.skipped++;
+			return false;
+		}
+		cached = value;
+		s_counters.issued++;
+		return true;
+	}
+
+	static int getCapabilityIndex(unsigned int cap) {
+		switch (cap) {
+		case GL_DEPTH_TEST: return (int)Capability::DEPTH_TEST;
+		case GL_CULL_FACE: return (int)Capability::CULL_FACE;
+		case GL_BLEND: return (int)Capability::BLEND;
+		case GL_STENCIL_TEST: return (int)Capability::STENCIL_TEST;
+		case GL_SCISSOR_TEST: return (int)Capability::SCISSOR_TEST;
+		default: return -1;
+		}
+	}
+
+	void GLState::useProgram(unsigned int program)
+	{
+		if (update(getState().program, program)) {
+			glUseProgram(program);
+		}
+	}
+
+	void GLState::bindVertexArray(unsigned int vao)
+	{
+		if (update(getState().vao, vao)) {
+			glBindVertexArray(vao);
+		}
+	}
+
+	void GLState::bindFramebuffer(unsigned int target, unsigned int framebuffer)
+	{
+		StateCache& state = getState();
+		if (target == GL_FRAMEBUFFER) {
+			if (state.drawFramebuffer == framebuffer && state.readFramebuffer == framebuffer) {
+				s_counters.skipped++;
+				return;
+			}
+			state.drawFramebuffer = state.readFramebuffer = framebuffer;
+			s_counters.issued++;
+			glBindFramebuffer(target, framebuffer);
+		}
+		else if (update(target == GL_READ_FRAMEBUFFER ? state.readFramebuffer : state.drawFramebuffer, framebuffer)) {
+			glBindFramebuffer(target, framebuffer);
+		}
+	}
+
+	void GLState::activeTexture(unsigned int unit)
+	{
+		if (update(getState().activeUnit, unit - GL_TEXTURE0)) {
+			glActiveTexture(unit);
+		}
+	}
+
+	void GLState::bindTexture(unsigned int target, unsigned int texture)
+	{
+		StateCache& state = getState();
+		if (state.activeUnit >= MAX_TEXTURE_UNITS) {
+			s_counters.issued++;
+			glBindTexture(target, texture);
+			return;
+		}
+		//A unit holds one binding per target, but only the last one is tracked. Names are unique across targets,
+		//so only unbinding (texture 0) needs the target to match
+		TextureBinding& binding = state.textures[state.activeUnit];
+		if (binding.texture == texture && (texture != 0 || binding.target == target)) {
+			s_counters.skipped++;
+			return;
+		}
+		binding.target = target;
+		binding.texture = texture;
+		s_counters.issued++;
+		glBindTexture(target, texture);
+	}
+
+	void GLState::bindTextureUnit(unsigned int unit, unsigned int texture)
+	{
+		StateCache& state = getState();
+		if (unit < MAX_TEXTURE_UNITS) {
+			TextureBinding& binding = state.textures[unit];
+			if (binding.texture == texture && texture != 0) {
+				s_counters.skipped++;
+				return;
+			}
+			binding.target = 0;
+			binding.texture = texture;
+		}
+		s_counters.issued++;
+		glBindTextureUnit(unit, texture);
+	}
+
+	void GLState::enable(unsigned int cap)
+	{
+		int index = getCapabilityIndex(cap);
+		if (index < 0) {
+			s_counters.issued++;
+			glEnable(cap);
+		}
+		else if (update(getState().capabilities[index], 1)) {
+			glEnable(cap);
+		}
+	}
+
+	void GLState::disable(unsigned int cap)
+	{
+		int index = getCapabilityIndex(cap);
+		if (index < 0) {
+			s_counters.issued++;
+			glDisable(cap);
+		}
+		else if (update(getState().capabilities[index], 0)) {
+			glDisable(cap);
+		}
+	}
+
+	void GLState::blendFunc(unsigned int srcFactor, unsigned int dstFactor)
+	{
+		StateCache& state = getState();
+		if (state.blendSrc == srcFactor && state.blendDst == dstFactor) {
+			s_counters.skipped++;
+			return;
+		}
+		state.blendSrc = srcFactor;
+		state.blendDst = dstFactor;
+		s_counters.issued++;
+		glBlendFunc(srcFactor, dstFactor);
+	}
+
+	void GLState::cullFace(unsigned int mode)
+	{
+		if (update(getState().cullFaceMode, mode)) {
+			glCullFace(mode);
+		}
+	}
+
+	void GLState::depthFunc(unsigned int func)
+	{
+		if (update(getState().depthFuncValue, func)) {
+			glDepthFunc(func);
+		}
+	}
+
+	void GLState::depthMask(bool writeDepth)
+	{
+		if (update(getState().depthMaskValue, writeDepth ? 1 : 0)) {
+			glDepthMask(writeDepth ? GL_TRUE : GL_FALSE);
+		}
+	}
+
+	void GLState::programDeleted(unsigned int program)
+	{
+		StateCache& state = getState();
+		if (state.program == program) {
+			state.program = UNKNOWN;
+		}
+	}
+
+	void GLState::vertexArrayDeleted(unsigned int vao)
+	{
+		StateCache& state = getState();
+		if (state.vao == vao) {
+			state.vao = 0;
+		}
+	}
+
+	void GLState::framebufferDeleted(unsigned int framebuffer)
+	{
+		StateCache& state = getState();
+		if (state.drawFramebuffer == framebuffer) {
+			state.drawFramebuffer = 0;
+		}
+		if (state.readFramebuffer == framebuffer) {
+			state.readFramebuffer = 0;
+		}
+	}
+
+	void GLState::textureDeleted(unsigned int texture)
+	{
+		StateCache& state = getState();
+		for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; i++)
+		{
+			if (state.textures[i].texture == texture) {
+				state.textures[i].texture = UNKNOWN;
+			}
+		}
+	}
+
+	void GLState::invalidate()
+	{
+		s_initialized = true;
+		s_state.program = UNKNOWN;
+		s_state.vao = UNKNOWN;
+		s_state.drawFramebuffer = UNKNOWN;
+		s_state.readFramebuffer = UNKNOWN;
+		s_state.activeUnit = UNKNOWN;
+		for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; i++)
+		{
+			s_state.textures[i].target = UNKNOWN;
+			s_state.textures[i].texture = UNKNOWN;
+		}
+		for (int i = 0; i < (int)Capability::COUNT; i++)
+		{
+			s_state.capabilities[i] = UNKNOWN;
+		}
+		s_state.blendSrc = s_state.blendDst = UNKNOWN;
+		s_state.cullFaceMode = UNKNOWN;
+		s_state.depthFuncValue = UNKNOWN;
+		s_state.depthMaskValue = UNKNOWN;
+	}
+
+	void GLState::beginFrame()
+	{
+		s_frameCounters = s_counters;
+		s_counters = GLStateCounters();
+	}
+
+	GLStateCounters GLState::getFrameCounters()
+	{
+		return s_frameCounters;
+	}
+
+	GLStateCounters GLState::getCounters()
+	{
+		return s_counters;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+namespace ew {
+	struct GLStateCounters {
+		unsigned int issued = 0; //Calls forwarded to GL
+		unsigned int skipped = 0; //Calls dropped because the state was already set
+	};
+
+	//Shadow copy of commonly changed GL state. Calls that would set state to its current value are dropped.
+	//Functions mirror the GL calls they replace. All code sharing the context must go through GLState for the tracked
+	//state, or call invalidate() after changing it directly. Assumes a single context on one thread.
+	class GLState {
+	public:
+		static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+		static void useProgram(unsigned int program);
+		static void bindVertexArray(unsigned int vao);
+		static void bindFramebuffer(unsigned int target, unsigned int framebuffer);
+		//unit is GL_TEXTURE0 + i, as with glActiveTexture
+		static void activeTexture(unsigned int unit);
+		static void bindTexture(unsigned int target, unsigned int texture);
+		//Binds to a unit without changing the active unit. unit is an index, as with glBindTextureUnit
+		static void bindTextureUnit(unsigned int unit, unsigned int texture);
+		//GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_STENCIL_TEST and GL_SCISSOR_TEST are tracked, other caps pass through
+		static void enable(unsigned int cap);
+		static void disable(unsigned int cap);
+		static void blendFunc(unsigned int srcFactor, unsigned int dstFactor);
+		static void cullFace(unsigned int mode);
+		static void depthFunc(unsigned int func);
+		static void depthMask(bool writeDepth);
+
+		//Call after deleting objects, since GL reverts deleted bindings to 0 and may reuse the name
+		static void programDeleted(unsigned int program);
+		static void vertexArrayDeleted(unsigned int vao);
+		static void framebufferDeleted(unsigned int framebuffer);
+		static void textureDeleted(unsigned int texture);
+		//Forgets all tracked state, so the next call of every kind is issued
+		static void invalidate();
+
+		//Starts a new frame of counters. getFrameCounters returns the frame that just ended
+		static void beginFrame();
+		static GLStateCounters getFrameCounters();
+		static GLStateCounters getCounters();
+	};
+}
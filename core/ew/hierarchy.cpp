@@ -0,0 +1,205 @@
+#include "hierarchy.h"
+#include <stdio.h>
+#include <algorithm>
+
+namespace ew {
+	const int TransformHierarchy::NO_PARENT;
+	//Nodes per parallel task. Levels smaller than this are updated on the calling thread
+	static const size_t PARALLEL_CHUNK_SIZE = 512;
+
+	void TransformHierarchy::reserve(size_t numNodes)
+	{
+		m_parents.reserve(numNodes);
+		m_depths.reserve(numNodes);
+		m_positions.reserve(numNodes);
+		m_rotations.reserve(numNodes);
+		m_scales.reserve(numNodes);
+		m_worldMatrices.reserve(numNodes);
+		m_dirty.reserve(numNodes);
+		m_changedNodes.reserve(numNodes);
+	}
+
+	void TransformHierarchy::clear()
+	{
+		m_parents.clear();
+		m_depths.clear();
+		m_positions.clear();
+		m_rotations.clear();
+		m_scales.clear();
+		m_worldMatrices.clear();
+		m_dirty.clear();
+		m_changedNodes.clear();
+		m_firstDirty = 0;
+		m_levelsValid = false;
+	}
+
+	/// <summary>
+	/// Appends a node. Requiring the parent to exist already is what keeps parents ahead of children
+	/// </summary>
+	/// <param name="parent">Index of the parent node, or NO_PARENT for a root</param>
+	/// <param name="local">Transform relative to the parent</param>
+	/// <returns>Index of the new node, or -1 if the parent doesn't exist</returns>
+	int TransformHierarchy::addNode(int parent, const Transform& local)
+	{
+		if (parent < NO_PARENT || parent >= (int)m_parents.size()) {
+			printf("TransformHierarchy: parent %d does not exist\n", parent);
+			return -1;
+		}
+		m_parents.push_back(parent);
+		m_depths.push_back(parent == NO_PARENT ? 0 : m_depths[parent] + 1);
+		m_positions.push_back(local.position);
+		m_rotations.push_back(local.rotation);
+		m_scales.push_back(local.scale);
+		m_worldMatrices.push_back(glm::mat4(1.0f));
+		m_dirty.push_back(0);
+		int node = (int)m_parents.size() - 1;
+		markDirty(node);
+		m_levelsValid = false;
+		return node;
+	}
+
+	void TransformHierarchy::setLocalPosition(int node, const glm::vec3& position)
+	{
+		m_positions[node] = position;
+		markDirty(node);
+	}
+
+	void TransformHierarchy::setLocalRotation(int node, const glm::quat& rotation)
+	{
+		m_rotations[node] = rotation;
+		markDirty(node);
+	}
+
+	void TransformHierarchy::setLocalScale(int node, const glm::vec3& scale)
+	{
+		m_scales[node] = scale;
+		markDirty(node);
+	}
+
+	void TransformHierarchy::setLocalTransform(int node, const Transform& local)
+	{
+		setLocalPosition(node, local.position);
+		setLocalRotation(node, local.rotation);
+		setLocalScale(node, local.scale);
+	}
+
+	void TransformHierarchy::markDirty(int node)
+	{
+		m_dirty[node] = 1;
+		if ((size_t)node < m_firstDirty) {
+			m_firstDirty = node;
+		}
+	}
+
+	/// <summary>
+	/// Recomputes a node's world matrix if it or its parent is dirty. The parent must already be up to date
+	/// </summary>
+	/// <returns>True if the node was recomputed</returns>
+	bool TransformHierarchy::updateNode(size_t node)
+	{
+		int parent = m_parents[node];
+		//A parent's flag stays set until the pass is done, so dirtiness flows down to every descendant
+		if (!m_dirty[node]) {
+			if (parent == NO_PARENT || !m_dirty[parent]) {
+				return false;
+			}
+			m_dirty[node] = 1;
+		}
+		glm::mat4 local = composeTRS(m_positions[node], m_rotations[node], m_scales[node]);
+		m_worldMatrices[node] = parent == NO_PARENT ? local : m_worldMatrices[parent] * local;
+		return true;
+	}
+
+	void TransformHierarchy::updateWorldMatrices()
+	{
+		m_changedNodes.clear();
+		const size_t numNodes = m_parents.size();
+		for (size_t i = m_firstDirty; i < numNodes; i++)
+		{
+			if (updateNode(i)) {
+				m_changedNodes.push_back((int)i);
+			}
+		}
+		for (int node : m_changedNodes)
+		{
+			m_dirty[node] = 0;
+		}
+		m_firstDirty = numNodes;
+	}
+
+	/// <summary>
+	/// Groups nodes by depth with a counting sort. Each level stays in ascending node order
+	/// </summary>
+	void TransformHierarchy::buildLevels()
+	{
+		const size_t numNodes = m_parents.size();
+		int maxDepth = -1;
+		for (size_t i = 0; i < numNodes; i++)
+		{
+			maxDepth = std::max(maxDepth, m_depths[i]);
+		}
+		m_levelStarts.assign(maxDepth + 2, 0);
+		for (size_t i = 0; i < numNodes; i++)
+		{
+			m_levelStarts[m_depths[i] + 1]++;
+		}
+		for (size_t level = 1; level < m_levelStarts.size(); level++)
+		{
+			m_levelStarts[level] += m_levelStarts[level - 1];
+		}
+		std::vector<size_t> next(m_levelStarts.begin(), m_levelStarts.end() - 1);
+		m_levelNodes.resize(numNodes);
+		//Filled in node order, so each level's slice is ascending
+		for (size_t i = 0; i < numNodes; i++)
+		{
+			m_levelNodes[next[m_depths[i]]++] = (int)i;
+		}
+		m_levelsValid = true;
+	}
+
+	void TransformHierarchy::updateWorldMatrices(ThreadPool& threadPool)
+	{
+		if (!hasChanges()) {
+			m_changedNodes.clear();
+			return;
+		}
+		if (!m_levelsValid) {
+			buildLevels();
+		}
+		//Each level only reads the level above it, which parallelFor has fully finished before returning
+		for (size_t level = 0; level + 1 < m_levelStarts.size(); level++)
+		{
+			//Nodes before m_firstDirty are clean, so skip them with a binary search of the ascending slice
+			const size_t end = m_levelStarts[level + 1];
+			const size_t start = std::lower_bound(m_levelNodes.begin() + m_levelStarts[level], m_levelNodes.begin() + end, (int)m_firstDirty) - m_levelNodes.begin();
+			const size_t count = end - start;
+			if (count < PARALLEL_CHUNK_SIZE * 2) {
+				for (size_t i = start; i < start + count; i++)
+				{
+					updateNode(m_levelNodes[i]);
+				}
+				continue;
+			}
+			const size_t numChunks = (count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+			threadPool.parallelFor(numChunks, [&](size_t chunk) {
+				size_t first = start + chunk * PARALLEL_CHUNK_SIZE;
+				size_t last = std::min(first + PARALLEL_CHUNK_SIZE, start + count);
+				for (size_t i = first; i < last; i++)
+				{
+					updateNode(m_levelNodes[i]);
+				}
+			});
+		}
+		//Gathered in node order so the list matches the serial update
+		m_changedNodes.clear();
+		const size_t numNodes = m_parents.size();
+		for (size_t i = m_firstDirty; i < numNodes; i++)
+		{
+			if (m_dirty[i]) {
+				m_changedNodes.push_back((int)i);
+				m_dirty[i] = 0;
+			}
+		}
+		m_firstDirty = numNodes;
+	}
+}
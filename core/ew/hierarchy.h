@@ -0,0 +1,71 @@
+#pragma once
+#include "transform.h"
+#include "threadPool.h"
+#include "transformBatch.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace ew {
+	//Tree of transforms stored as arrays, one entry per node. Parents are always stored before their children,
+	//so every world matrix is computed in one forward pass with its parent's matrix already done.
+	//World matrices are kept until the next update, so several passes can share them.
+	//Setting a local transform marks the node dirty, and an update only recomputes dirty nodes and their descendants.
+	//Large hierarchies can be updated level by level on a ThreadPool, since nodes of the same depth don't depend on each other.
+	class TransformHierarchy {
+	public:
+		static const int NO_PARENT = -1;
+
+		void reserve(size_t numNodes);
+		void clear();
+		//Adds a node under an existing node, or as a root. Returns the node's index
+		int addNode(int parent = NO_PARENT, const Transform& local = Transform());
+		inline size_t getNumNodes()const { return m_parents.size(); }
+		inline int getParent(int node)const { return m_parents[node]; }
+		//Number of ancestors. Roots are depth 0
+		inline int getDepth(int node)const { return m_depths[node]; }
+
+		void setLocalPosition(int node, const glm::vec3& position);
+		void setLocalRotation(int node, const glm::quat& rotation);
+		void setLocalScale(int node, const glm::vec3& scale);
+		void setLocalTransform(int node, const Transform& local);
+		inline const glm::vec3& getLocalPosition(int node)const { return m_positions[node]; }
+		inline const glm::quat& getLocalRotation(int node)const { return m_rotations[node]; }
+		inline const glm::vec3& getLocalScale(int node)const { return m_scales[node]; }
+
+		//Forces the node and its descendants to be recomputed on the next update
+		void markDirty(int node);
+		inline bool hasChanges()const { return m_firstDirty < m_parents.size(); }
+
+		//Recomputes world matrices of dirty nodes and their descendants. Does nothing if no node changed
+		void updateWorldMatrices();
+		//Nodes whose world matrix changed in the last update, in ascending order.
+		//Use with InstanceBuffer::setSubData to upload only what changed
+		inline const std::vector<int>& getChangedNodes()const { return m_changedNodes; }
+		//Same as updateWorldMatrices(), but nodes of each depth are split across the pool.
+		//Results, including the changed node list, are identical to the serial update
+		void updateWorldMatrices(ThreadPool& threadPool);
+		inline size_t getNumLevels()const { return m_levelStarts.empty() ? 0 : m_levelStarts.size() - 1; }
+		inline const glm::mat4& getWorldMatrix(int node)const { return m_worldMatrices[node]; }
+		//All world matrices in node order, e.g. for uploading to an InstanceBuffer
+		inline const std::vector<glm::mat4>& getWorldMatrices()const { return m_worldMatrices; }
+	private:
+		bool updateNode(size_t node);
+		void buildLevels();
+
+		std::vector<int> m_parents;
+		std::vector<int> m_depths;
+		std::vector<glm::vec3> m_positions;
+		std::vector<glm::quat> m_rotations;
+		std::vector<glm::vec3> m_scales;
+		std::vector<glm::mat4> m_worldMatrices;
+		std::vector<uint8_t> m_dirty;
+		size_t m_firstDirty = 0; //Lowest dirty node. Nothing before it can change, since parents come first
+		std::vector<int> m_changedNodes;
+		//Node indices sorted by depth. Nodes of level i are m_levelNodes[m_levelStarts[i]] to m_levelNodes[m_levelStarts[i + 1] - 1]
+		std::vector<int> m_levelNodes;
+		std::vector<size_t> m_levelStarts;
+		bool m_levelsValid = false;
+	};
+}
@@ -0,0 +1,211 @@
+#include "instanceBuffer.h"
+#include "external/glad.h"
+#include <stdio.h>
+
+namespace ew {
+	InstanceTRS toInstanceTRS(const Transform& transform) {
+		InstanceTRS instance;
+		instance.rotation = glm::vec4(transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w);
+		instance.position = transform.position;
+		instance.scale = transform.scale;
+		return instance;
+	}
+
+	InstanceBuffer::InstanceBuffer(InstanceFormat format)
+		: m_format(format)
+	{
+		glGenBuffers(1, &m_buffer);
+	}
+
+	InstanceBuffer::~InstanceBuffer()
+	{
+		glDeleteBuffers(1, &m_buffer);
+	}
+
+	/// <summary>
+	/// Uploads instance data, reallocating only when the buffer needs to grow
+	/// </summary>
+	void InstanceBuffer::upload(const void* data, unsigned int count, unsigned int stride)
+	{
+		size_t size = (size_t)count * stride;
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		if (size > m_capacityBytes) {
+			glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
+			m_capacityBytes = size;
+		}
+		else if (size > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_count = count;
+	}
+
+	void InstanceBuffer::setData(const glm::mat4* models, unsigned int count)
+	{
+		if (m_format != InstanceFormat::MAT4) {
+			printf("InstanceBuffer: buffer does not hold mat4 instances\n");
+			return;
+		}
+		upload(models, count, sizeof(glm::mat4));
+	}
+
+	void InstanceBuffer::setData(const InstanceTRS* instances, unsigned int count)
+	{
+		if (m_format != InstanceFormat::TRS) {
+			printf("InstanceBuffer: buffer does not hold TRS instances\n");
+			return;
+		}
+		upload(instances, count, sizeof(InstanceTRS));
+	}
+
+	void InstanceBuffer::setData(const Affine3x4* instances, unsigned int count)
+	{
+		if (m_format != InstanceFormat::AFFINE) {
+			printf("InstanceBuffer: buffer does not hold affine instances\n");
+			return;
+		}
+		upload(instances, count, sizeof(Affine3x4));
+	}
+
+	void InstanceBuffer::setData(const std::vector<glm::mat4>& models)
+	{
+		setData(models.data(), models.size());
+	}
+
+	void InstanceBuffer::setData(const std::vector<InstanceTRS>& instances)
+	{
+		setData(instances.data(), instances.size());
+	}
+
+	void InstanceBuffer::setData(const std::vector<Affine3x4>& instances)
+	{
+		setData(instances.data(), instances.size());
+	}
+
+	void InstanceBuffer::setData(const std::vector<Transform>& transforms)
+	{
+		if (m_format == InstanceFormat::TRS) {
+			std::vector<InstanceTRS> instances(transforms.size());
+			for (size_t i = 0; i < transforms.size(); i++)
+			{
+				instances[i] = toInstanceTRS(transforms[i]);
+			}
+			setData(instances);
+			return;
+		}
+		//Matrix formats go through the batched SIMD path
+		TransformSoA soa;
+		soa.resize(transforms.size());
+		for (size_t i = 0; i < transforms.size(); i++)
+		{
+			soa.set(i, transforms[i]);
+		}
+		setData(soa);
+	}
+
+	void InstanceBuffer::setData(const TransformSoA& transforms)
+	{
+		if (m_format == InstanceFormat::MAT4) {
+			std::vector<glm::mat4> models(transforms.size());
+			composeMatrices(transforms, models.data());
+			setData(models);
+		}
+		else if (m_format == InstanceFormat::AFFINE) {
+			std::vector<Affine3x4> instances(transforms.size());
+			composeAffineMatrices(transforms, instances.data());
+			setData(instances);
+		}
+		else {
+			std::vector<InstanceTRS> instances(transforms.size());
+			for (size_t i = 0; i < transforms.size(); i++)
+			{
+				instances[i] = toInstanceTRS(transforms.get(i));
+			}
+			setData(instances);
+		}
+	}
+
+	void InstanceBuffer::setSubData(const std::vector<glm::mat4>& models, const std::vector<int>& changed)
+	{
+		if (m_format != InstanceFormat::MAT4) {
+			printf("InstanceBuffer: buffer does not hold mat4 instances\n");
+			return;
+		}
+		if (changed.empty()) {
+			return;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		size_t runStart = 0;
+		for (size_t i = 1; i <= changed.size(); i++)
+		{
+			if (i < changed.size() && changed[i] == changed[i - 1] + 1) {
+				continue;
+			}
+			unsigned int first = changed[runStart];
+			unsigned int count = changed[i - 1] - first + 1;
+			if (first + count > m_count) {
+				printf("InstanceBuffer: instances %u-%u are past the end of the buffer\n", first, first + count - 1);
+				break;
+			}
+			glBufferSubData(GL_ARRAY_BUFFER, (size_t)first * sizeof(glm::mat4), (size_t)count * sizeof(glm::mat4), &models[first]);
+			runStart = i;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	unsigned int InstanceBuffer::setVisibleData(const Frustum& frustum, const BoundingSphere& localSphere, const glm::mat4* models, unsigned int count)
+	{
+		if (m_format != InstanceFormat::MAT4) {
+			printf("InstanceBuffer: buffer does not hold mat4 instances\n");
+			return 0;
+		}
+		m_visible.resize(count);
+		cullInstances(frustum, localSphere, models, count, m_visible.data());
+		m_visibleModels.clear();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (m_visible[i]) {
+				m_visibleModels.push_back(models[i]);
+			}
+		}
+		setData(m_visibleModels);
+		return m_visibleModels.size();
+	}
+
+	void InstanceBuffer::bindAttributes() const
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		const unsigned int loc = INSTANCE_ATTRIBUTE_LOCATION;
+		if (m_format == InstanceFormat::MAT4) {
+			//A mat4 attribute takes up 4 consecutive vec4 locations
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				glVertexAttribPointer(loc + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (const void*)(sizeof(glm::vec4) * i));
+				glVertexAttribDivisor(loc + i, 1);
+				glEnableVertexAttribArray(loc + i);
+			}
+		}
+		else if (m_format == InstanceFormat::AFFINE) {
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				glVertexAttribPointer(loc + i, 4, GL_FLOAT, GL_FALSE, sizeof(Affine3x4), (const void*)(sizeof(glm::vec4) * i));
+				glVertexAttribDivisor(loc + i, 1);
+				glEnableVertexAttribArray(loc + i);
+			}
+			glDisableVertexAttribArray(loc + 3);
+		}
+		else {
+			glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceTRS), (const void*)offsetof(InstanceTRS, rotation));
+			glVertexAttribPointer(loc + 1, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceTRS), (const void*)offsetof(InstanceTRS, position));
+			glVertexAttribPointer(loc + 2, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceTRS), (const void*)offsetof(InstanceTRS, scale));
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				glVertexAttribDivisor(loc + i, 1);
+				glEnableVertexAttribArray(loc + i);
+			}
+			//Location 7 may be left enabled from a previous MAT4 buffer
+			glDisableVertexAttribArray(loc + 3);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "transform.h"
+#include "transformBatch.h"
+#include "frustum.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace ew {
+	//Per-instance data layout. Attributes start at INSTANCE_ATTRIBUTE_LOCATION and advance once per instance
+	enum class InstanceFormat {
+		MAT4 = 0, //64 bytes. Model matrix in locations 4-7
+		TRS = 1, //40 bytes. vec4 rotation quaternion (xyzw) in 4, vec3 position in 5, vec3 scale in 6
+		AFFINE = 2 //48 bytes. Affine3x4 rows in locations 4-6. See transformBatch.h
+	};
+	//TRS instances are expanded in the vertex shader with:
+	//	vec3 rotate(vec4 q, vec3 v) { return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v); }
+	//	vec3 worldPos = iPosition + rotate(iRotation, vPos * iScale);
+
+	const unsigned int INSTANCE_ATTRIBUTE_LOCATION = 4;
+
+	struct InstanceTRS {
+		glm::vec4 rotation;
+		glm::vec3 position;
+		glm::vec3 scale;
+	};
+
+	InstanceTRS toInstanceTRS(const Transform& transform);
+
+	//GPU buffer of per-instance data, attached to a Mesh or Model with setInstanceBuffer()
+	class InstanceBuffer {
+	public:
+		InstanceBuffer(InstanceFormat format = InstanceFormat::MAT4);
+		~InstanceBuffer();
+		InstanceBuffer(const InstanceBuffer&) = delete;
+		InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+		//Uploads instances. Data must match the buffer's format
+		void setData(const glm::mat4* models, unsigned int count);
+		void setData(const InstanceTRS* instances, unsigned int count);
+		void setData(const Affine3x4* instances, unsigned int count);
+		void setData(const std::vector<glm::mat4>& models);
+		void setData(const std::vector<InstanceTRS>& instances);
+		void setData(const std::vector<Affine3x4>& instances);
+		//Converts transforms into the buffer's format and uploads them
+		void setData(const std::vector<Transform>& transforms);
+		void setData(const TransformSoA& transforms);
+		//Re-uploads only the listed instances of a MAT4 buffer, one upload per run of consecutive indices.
+		//Indices must be ascending and within the current count, e.g. TransformHierarchy::getChangedNodes()
+		void setSubData(const std::vector<glm::mat4>& models, const std::vector<int>& changed);
+		//Frustum culls instances of a MAT4 buffer with cullInstances and uploads only the visible models, in order.
+		//localSphere is the bounds of the drawn mesh or model. Returns the number uploaded, which is the instance count to draw
+		unsigned int setVisibleData(const Frustum& frustum, const BoundingSphere& localSphere, const glm::mat4* models, unsigned int count);
+
+		//Sets up instanced attributes on the currently bound VAO
+		void bindAttributes()const;
+
+		inline InstanceFormat getFormat()const { return m_format; }
+		inline unsigned int getCount()const { return m_count; }
+		inline unsigned int getBuffer()const { return m_buffer; }
+	private:
+		void upload(const void* data, unsigned int count, unsigned int stride);
+		InstanceFormat m_format;
+		unsigned int m_buffer = 0;
+		unsigned int m_count = 0;
+		size_t m_capacityBytes = 0;
+		//Scratch for setVisibleData, kept to avoid allocating every frame
+		std::vector<uint8_t> m_visible;
+		std::vector<glm::mat4> m_visibleModels;
+	};
+}
@@ -6,65 +6,320 @@
 */
 
 #include "mesh.h"
+#include "instanceBuffer.h"
+#include "shader.h"
+#include "glState.h"
 #include "external/glad.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <stdio.h>
 
 namespace ew {
-	Mesh::Mesh(const MeshData& meshData)
-	{
-		load(meshData);
+	//mat4 that maps PACKED_QUANTIZED positions back to object space, declared in vertexFormat.glsl
+	constexpr uint32_t DEQUANTIZE_UNIFORM = uniformHash("_Dequantize");
+
+	static float signNotZero(float v) {
+		return v >= 0.0f ? 1.0f : -1.0f;
 	}
-	void Mesh::load(const MeshData& meshData)
-	{
-		if (!m_initialized) {
-			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
 
-			glGenBuffers(1, &m_vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	/// <summary>
+	/// Encodes a unit vector onto the octahedron, unfolded into [-1,1]^2
+	/// </summary>
+	glm::vec2 octEncode(const glm::vec3& normal) {
+		float l1 = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+		if (l1 <= 0.0f) {
+			return glm::vec2(0.0f, 0.0f);
+		}
+		glm::vec3 n = normal / l1;
+		if (n.z < 0.0f) {
+			return glm::vec2((1.0f - glm::abs(n.y)) * signNotZero(n.x), (1.0f - glm::abs(n.x)) * signNotZero(n.y));
+		}
+		return glm::vec2(n.x, n.y);
+	}
 
-			glGenBuffers(1, &m_ebo);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-			//Position attribute
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-			glEnableVertexAttribArray(0);
+	/// <summary>
+	/// Inverse of octEncode. Matches octDecode in vertexFormat.glsl
+	/// </summary>
+	glm::vec3 octDecode(const glm::vec2& encoded) {
+		glm::vec3 n = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+		float t = glm::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
 
-			//Normal attribute
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
-			glEnableVertexAttribArray(1);
+	static void packNormal(const glm::vec3& normal, int16_t* out) {
+		glm::vec2 e = octEncode(normal);
+		out[0] = (int16_t)glm::packSnorm1x16(e.x);
+		out[1] = (int16_t)glm::packSnorm1x16(e.y);
+	}
 
-			//UV attribute
+	static void packUV(const glm::vec2& uv, uint16_t* out) {
+		out[0] = glm::packHalf1x16(uv.x);
+		out[1] = glm::packHalf1x16(uv.y);
+	}
+
+	/// <summary>
+	/// Points VAO attributes 0,1,2 at the currently bound GL_ARRAY_BUFFER, using the layout of the given format
+	/// </summary>
+	static void setupVertexAttributes(VertexFormat vertexFormat) {
+		switch (vertexFormat) {
+		case VertexFormat::PACKED:
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, pos));
+			glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, normal));
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, uv));
+			break;
+		case VertexFormat::PACKED_QUANTIZED:
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedVertex), (const void*)offsetof(QuantizedVertex, pos));
+			glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), (const void*)offsetof(QuantizedVertex, normal));
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(QuantizedVertex), (const void*)offsetof(QuantizedVertex, uv));
+			break;
+		default:
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
 			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
-			glEnableVertexAttribArray(2);
+			break;
+		}
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+	}
+
+	/// <summary>
+	/// Uploads vertices to the currently bound GL_ARRAY_BUFFER, converting them to the given format.
+	/// </summary>
+	/// <param name="bounds">Bounds of the vertices, used as the quantization range</param>
+	/// <param name="dequantizeMatrix">Set to the matrix that maps quantized positions back to object space</param>
+	static void uploadVertices(const Vertex* vertices, unsigned int numVertices, VertexFormat vertexFormat, const AABB& bounds, glm::mat4* dequantizeMatrix) {
+		*dequantizeMatrix = glm::mat4(1.0f);
+		if (vertexFormat == VertexFormat::PACKED) {
+			std::vector<PackedVertex> packed(numVertices);
+			for (size_t i = 0; i < numVertices; i++)
+			{
+				packed[i].pos = vertices[i].pos;
+				packNormal(vertices[i].normal, packed[i].normal);
+				packUV(vertices[i].uv, packed[i].uv);
+			}
+			glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex) * packed.size(), packed.data(), GL_STATIC_DRAW);
+		}
+		else if (vertexFormat == VertexFormat::PACKED_QUANTIZED) {
+			glm::vec3 boundsMin = bounds.min;
+			glm::vec3 extent = bounds.max - bounds.min;
+			//Avoid divide by zero on flat meshes like planes
+			for (int c = 0; c < 3; c++)
+			{
+				if (extent[c] <= 0.0f) {
+					extent[c] = 1.0f;
+				}
+			}
+			std::vector<QuantizedVertex> packed(numVertices);
+			for (size_t i = 0; i < numVertices; i++)
+			{
+				glm::vec3 p = (vertices[i].pos - boundsMin) / extent;
+				packed[i].pos[0] = glm::packUnorm1x16(p.x);
+				packed[i].pos[1] = glm::packUnorm1x16(p.y);
+				packed[i].pos[2] = glm::packUnorm1x16(p.z);
+				packed[i].pos[3] = 0;
+				packNormal(vertices[i].normal, packed[i].normal);
+				packUV(vertices[i].uv, packed[i].uv);
+			}
+			glBufferData(GL_ARRAY_BUFFER, sizeof(QuantizedVertex) * packed.size(), packed.data(), GL_STATIC_DRAW);
+			*dequantizeMatrix = glm::scale(glm::translate(glm::mat4(1.0f), boundsMin), extent);
+		}
+		else {
+			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * (size_t)numVertices, vertices, GL_STATIC_DRAW);
+		}
+	}
+
+	/// <summary>
+	/// Splits a triangle list into submeshes that each reference at most maxVertices vertices,
+	/// so that every submesh can be drawn with 16 bit indices. Vertices shared across a split are duplicated.
+	/// </summary>
+	/// <param name="meshData">Triangle list to split</param>
+	/// <param name="maxVertices">Maximum vertex count per submesh</param>
+	/// <returns>The submeshes. A single copy of the input if it already fits</returns>
+	std::vector<MeshData> splitMeshData(const MeshData& meshData, unsigned int maxVertices) {
+		std::vector<MeshData> submeshes;
+		if (meshData.vertices.size() <= maxVertices || maxVertices < 3) {
+			submeshes.push_back(meshData);
+			return submeshes;
+		}
+		const unsigned int unmapped = 0xFFFFFFFF;
+		//Maps source vertex index -> index in the current submesh. Stamped with the submesh number so it never needs clearing
+		std::vector<unsigned int> remap(meshData.vertices.size(), unmapped);
+		std::vector<unsigned int> remapOwner(meshData.vertices.size(), unmapped);
+		submeshes.emplace_back();
+		for (size_t t = 0; t + 2 < meshData.indices.size(); t += 3)
+		{
+			MeshData* current = &submeshes.back();
+			unsigned int owner = (unsigned int)submeshes.size() - 1;
+			unsigned int newVertices = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				if (remapOwner[meshData.indices[t + k]] != owner) {
+					newVertices++;
+				}
+			}
+			if (current->vertices.size() + newVertices > maxVertices) {
+				submeshes.emplace_back();
+				current = &submeshes.back();
+				owner++;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int index = meshData.indices[t + k];
+				if (remapOwner[index] != owner) {
+					remapOwner[index] = owner;
+					remap[index] = (unsigned int)current->vertices.size();
+					current->vertices.push_back(meshData.vertices[index]);
+				}
+				current->indices.push_back(remap[index]);
+			}
+		}
+		for (size_t i = 0; i < submeshes.size(); i++)
+		{
+			submeshes[i].bounds = computeBounds(submeshes[i].vertices.data(), submeshes[i].vertices.size());
+		}
+		return submeshes;
+	}
 
+	Mesh::Mesh(const MeshData& meshData, VertexFormat vertexFormat)
+	{
+		load(meshData, vertexFormat);
+	}
+	void Mesh::load(const MeshData& meshData, VertexFormat vertexFormat)
+	{
+		//Small meshes use 16 bit indices to halve index memory and bandwidth
+		if (meshData.vertices.size() <= MAX_16BIT_INDEX_VERTICES) {
+			std::vector<uint16_t> shortIndices(meshData.indices.begin(), meshData.indices.end());
+			load(meshData.vertices.data(), meshData.vertices.size(), shortIndices.data(), shortIndices.size(), GL_UNSIGNED_SHORT, vertexFormat, &meshData.bounds);
+		}
+		else {
+			load(meshData.vertices.data(), meshData.vertices.size(), meshData.indices.data(), meshData.indices.size(), GL_UNSIGNED_INT, vertexFormat, &meshData.bounds);
+		}
+	}
+	/// <summary>
+	/// Uploads vertex and index data straight from memory, without going through MeshData
+	/// </summary>
+	/// <param name="indices">Index data of type indexType</param>
+	/// <param name="indexType">GL_UNSIGNED_SHORT or GL_UNSIGNED_INT</param>
+	/// <param name="bounds">Precomputed bounds of the vertices. Computed here if null or empty</param>
+	void Mesh::load(const Vertex* vertices, unsigned int numVertices, const void* indices, unsigned int numIndices, unsigned int indexType, VertexFormat vertexFormat, const Bounds* bounds)
+	{
+		if (!m_initialized) {
+			glGenVertexArrays(1, &m_vao);
+			glGenBuffers(1, &m_vbo);
+			glGenBuffers(1, &m_ebo);
 			m_initialized = true;
 		}
 
-		glBindVertexArray(m_vao);
+		GLState::bindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
-		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+		//Attribute layout depends on the format, so it is set up on every load
+		setupVertexAttributes(vertexFormat);
+		m_vertexFormat = vertexFormat;
+		m_bounds = bounds != nullptr && bounds->aabb.isValid() ? *bounds : computeBounds(vertices, numVertices);
+
+		if (numVertices > 0) {
+			uploadVertices(vertices, numVertices, vertexFormat, m_bounds.aabb, &m_dequantizeMatrix);
 		}
-		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+		m_indexType = indexType;
+		if (numIndices > 0) {
+			size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * numIndices, indices, GL_STATIC_DRAW);
 		}
-		m_numVertices = meshData.vertices.size();
-		m_numIndices = meshData.indices.size();
+		m_numVertices = numVertices;
+		m_numIndices = numIndices;
 
-		glBindVertexArray(0);
+		GLState::bindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
+	std::vector<std::string> getVertexFormatDefines(VertexFormat vertexFormat)
+	{
+		switch (vertexFormat) {
+		case VertexFormat::PACKED: return { "PACKED_VERTEX" };
+		case VertexFormat::PACKED_QUANTIZED: return { "PACKED_VERTEX", "QUANTIZED_VERTEX" };
+		default: return {};
+		}
+	}
+
 	void Mesh::draw(ew::DrawMode drawMode) const
 	{
-		glBindVertexArray(m_vao);
+		GLState::bindVertexArray(m_vao);
 		if (drawMode == DrawMode::TRIANGLES) {
-			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
+			glDrawElements(GL_TRIANGLES, m_numIndices, m_indexType, NULL);
 		}
 		else {
 			glDrawArrays(GL_POINTS, 0, m_numVertices);
 		}
 		
 	}
-}
\ No newline at end of file
+	void Mesh::draw(const Shader& shader, DrawMode drawMode) const
+	{
+		if (m_vertexFormat == VertexFormat::PACKED_QUANTIZED) {
+			shader.setMat4(shader.getUniform(DEQUANTIZE_UNIFORM), m_dequantizeMatrix);
+		}
+		draw(drawMode);
+	}
+	void Mesh::unload()
+	{
+		if (!m_initialized) {
+			return;
+		}
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		glDeleteVertexArrays(1, &m_vao);
+		GLState::vertexArrayDeleted(m_vao);
+		m_vao = m_vbo = m_ebo = 0;
+		m_numVertices = m_numIndices = 0;
+		m_initialized = false;
+	}
+	size_t Mesh::getGpuBytes() const
+	{
+		size_t indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+		return getVertexSize(m_vertexFormat) * m_numVertices + indexSize * m_numIndices;
+	}
+	Bounds computeBounds(const Vertex* vertices, size_t numVertices) {
+		if (numVertices == 0) {
+			return Bounds();
+		}
+		return computeBounds(&vertices[0].pos, numVertices, sizeof(Vertex));
+	}
+	size_t getVertexSize(VertexFormat vertexFormat) {
+		switch (vertexFormat) {
+		case VertexFormat::PACKED: return sizeof(PackedVertex);
+		case VertexFormat::PACKED_QUANTIZED: return sizeof(QuantizedVertex);
+		default: return sizeof(Vertex);
+		}
+	}
+	void Mesh::setInstanceBuffer(const InstanceBuffer* instanceBuffer)
+	{
+		if (!m_initialized) {
+			printf("Mesh: load() must be called before setInstanceBuffer()\n");
+			return;
+		}
+		GLState::bindVertexArray(m_vao);
+		instanceBuffer->bindAttributes();
+		GLState::bindVertexArray(0);
+	}
+	void Mesh::drawInstanced(unsigned int instanceCount, DrawMode drawMode) const
+	{
+		GLState::bindVertexArray(m_vao);
+		if (drawMode == DrawMode::TRIANGLES) {
+			glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, m_indexType, NULL, instanceCount);
+		}
+		else {
+			glDrawArraysInstanced(GL_POINTS, 0, m_numVertices, instanceCount);
+		}
+	}
+	void Mesh::drawInstanced(const Shader& shader, unsigned int instanceCount, DrawMode drawMode) const
+	{
+		if (m_vertexFormat == VertexFormat::PACKED_QUANTIZED) {
+			shader.setMat4(shader.getUniform(DEQUANTIZE_UNIFORM), m_dequantizeMatrix);
+		}
+		drawInstanced(instanceCount, drawMode);
+	}
+}
@@ -3,8 +3,11 @@
 */
 
 #pragma once
+#include "bounds.h"
 #include <glm/glm.hpp>
 #include <vector>
+#include <string>
+#include <cstdint>
 
 namespace ew {
 	struct Vertex {
@@ -16,6 +19,33 @@ namespace ew {
 	struct MeshData {
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		Bounds bounds; //Object space bounds. Set by model loading and procGen, call computeBounds after editing vertices
+	};
+
+	//GPU vertex layout used when uploading a mesh. MeshData is always stored as full floats on the CPU.
+	//Attribute locations are the same in every format: 0 = position, 1 = normal, 2 = uv
+	enum class VertexFormat {
+		STANDARD = 0, //32 bytes. vec3 pos, vec3 normal, vec2 uv
+		PACKED = 1, //20 bytes. vec3 pos, octahedral normal (2x snorm16), half float uv
+		PACKED_QUANTIZED = 2 //16 bytes. Same as PACKED, with unorm16 positions. See Mesh::getDequantizeMatrix()
+	};
+	//Packed formats deliver the normal as an octahedral vec2 at location 1, and PACKED_QUANTIZED positions are in [0,1].
+	//Stock shaders that read a vec3 normal can't draw them. Vertex shaders should include assets/vertexFormat.glsl,
+	//compile with getVertexFormatDefines(), and read attributes through getVertexPosition() and getVertexNormal().
+
+	//Shader defines that select the matching inputs in vertexFormat.glsl: PACKED_VERTEX, plus QUANTIZED_VERTEX for PACKED_QUANTIZED
+	std::vector<std::string> getVertexFormatDefines(VertexFormat vertexFormat);
+
+	struct PackedVertex {
+		glm::vec3 pos;
+		int16_t normal[2];
+		uint16_t uv[2];
+	};
+
+	struct QuantizedVertex {
+		uint16_t pos[4]; //w is padding to keep attributes 4 byte aligned
+		int16_t normal[2];
+		uint16_t uv[2];
 	};
 
 	enum class DrawMode {
@@ -23,14 +53,37 @@ namespace ew {
 		POINTS = 1
 	};
 
+	class InstanceBuffer;
+	class Shader;
+
 	class Mesh {
 	public:
 		Mesh() {};
-		Mesh(const MeshData& meshData);
-		void load(const MeshData& meshData);
+		Mesh(const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::STANDARD);
+		void load(const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::STANDARD);
+		//Deletes GL objects. The mesh can be loaded again afterwards
+		void unload();
+		//bounds can pass along bounds the caller already has, so they aren't computed twice
+		void load(const Vertex* vertices, unsigned int numVertices, const void* indices, unsigned int numIndices, unsigned int indexType, VertexFormat vertexFormat = VertexFormat::STANDARD, const Bounds* bounds = nullptr);
 		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Also sets shader's mat4 _Dequantize uniform (see vertexFormat.glsl) for PACKED_QUANTIZED meshes.
+		//shader should be the bound program. Shaders without the uniform are left untouched
+		void draw(const Shader& shader, DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Attaches per-instance attributes to this mesh's VAO. See instanceBuffer.h
+		void setInstanceBuffer(const InstanceBuffer* instanceBuffer);
+		void drawInstanced(unsigned int instanceCount, DrawMode drawMode = DrawMode::TRIANGLES)const;
+		void drawInstanced(const Shader& shader, unsigned int instanceCount, DrawMode drawMode = DrawMode::TRIANGLES)const;
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		inline VertexFormat getVertexFormat()const { return m_vertexFormat; }
+		//GL_UNSIGNED_SHORT when every vertex fits in 16 bits, otherwise GL_UNSIGNED_INT
+		inline unsigned int getIndexType()const { return m_indexType; }
+		size_t getGpuBytes()const;
+		//Maps quantized [0,1] positions back to object space. Identity unless the format is PACKED_QUANTIZED.
+		//For position-only passes (e.g. shadow depth) this can be folded into the model matrix: model * getDequantizeMatrix()
+		inline const glm::mat4& getDequantizeMatrix()const { return m_dequantizeMatrix; }
+		//Object space bounds of the loaded vertices
+		inline const Bounds& getBounds()const { return m_bounds; }
 	private:
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
@@ -38,5 +91,20 @@ namespace ew {
 		unsigned int m_ebo = 0;
 		unsigned int m_numVertices = 0;
 		unsigned int m_numIndices = 0;
+		unsigned int m_indexType = 0x1405; //GL_UNSIGNED_INT
+		VertexFormat m_vertexFormat = VertexFormat::STANDARD;
+		glm::mat4 m_dequantizeMatrix = glm::mat4(1.0f);
+		Bounds m_bounds;
 	};
+
+	//Largest vertex count that can be drawn with 16 bit indices
+	const unsigned int MAX_16BIT_INDEX_VERTICES = 65535;
+	std::vector<MeshData> splitMeshData(const MeshData& meshData, unsigned int maxVertices = MAX_16BIT_INDEX_VERTICES);
+
+	size_t getVertexSize(VertexFormat vertexFormat);
+	//Bounds of vertex positions. Empty if there are no vertices
+	Bounds computeBounds(const Vertex* vertices, size_t numVertices);
+
+	glm::vec2 octEncode(const glm::vec3& normal);
+	glm::vec3 octDecode(const glm::vec2& encoded);
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "meshCache.h"
+#include "fileUtils.h"
+#include "external/glad.h"
+#include <sys/stat.h>
+#include <fstream>
+#include <cstddef>
+#include <string.h>
+#include <stdio.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ew {
+	static const char MESH_CACHE_MAGIC[4] = { 'E', 'W', 'M', 'C' };
+	static const size_t MESH_CACHE_ALIGNMENT = 16;
+
+	struct MeshCacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t flags;
+		uint32_t numMeshes;
+		uint64_t sourceSize;
+		int64_t sourceModifiedTime;
+		uint64_t sourceHash;
+	};
+
+	struct MeshCacheTableEntry {
+		uint32_t numVertices;
+		uint32_t numIndices;
+		uint32_t indexType;
+		uint32_t padding;
+		uint64_t verticesOffset;
+		uint64_t indicesOffset;
+	};
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& filePath)
+	{
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			CloseHandle(file);
+			return false;
+		}
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == NULL) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_fileHandle = file;
+		m_mappingHandle = mapping;
+		m_data = (const unsigned char*)data;
+		m_size = (size_t)size.QuadPart;
+#else
+		int fd = ::open(filePath.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+		void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		//The mapping keeps the file referenced, so the descriptor isn't needed anymore
+		::close(fd);
+		if (data == MAP_FAILED) {
+			return false;
+		}
+		m_data = (const unsigned char*)data;
+		m_size = (size_t)info.st_size;
+#endif
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data == nullptr) {
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle((HANDLE)m_mappingHandle);
+		CloseHandle((HANDLE)m_fileHandle);
+		m_mappingHandle = nullptr;
+		m_fileHandle = nullptr;
+#else
+		munmap((void*)m_data, m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	//FNV-1a
+	static uint64_t hashBytes(const unsigned char* data, size_t size) {
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static bool getSourceInfo(const std::string& sourcePath, uint64_t* size, int64_t* modifiedTime) {
+		struct stat info;
+		if (stat(sourcePath.c_str(), &info) != 0) {
+			return false;
+		}
+		*size = (uint64_t)info.st_size;
+		*modifiedTime = (int64_t)info.st_mtime;
+		return true;
+	}
+
+	static bool hashSourceFile(const std::string& sourcePath, uint64_t* hash) {
+		MappedFile source;
+		if (!source.open(sourcePath)) {
+			return false;
+		}
+		*hash = hashBytes(source.getData(), source.getSize());
+		return true;
+	}
+
+	//True if count elements starting at offset fit in size bytes. Written so corrupt values can't overflow
+	static bool isRangeInside(uint64_t offset, uint64_t count, uint64_t elementSize, size_t size) {
+		if (offset > size) {
+			return false;
+		}
+		return count <= ((uint64_t)size - offset) / elementSize;
+	}
+
+	//True if every index is less than numVertices, so no draw reads past the vertex buffer
+	template<typename T>
+	static bool areIndicesInside(const T* indices, size_t numIndices, uint32_t numVertices) {
+		T maxIndex = 0;
+		for (size_t i = 0; i < numIndices; i++)
+		{
+			maxIndex = indices[i] > maxIndex ? indices[i] : maxIndex;
+		}
+		return numIndices == 0 || maxIndex < numVertices;
+	}
+
+	static bool readHeader(const std::string& cachePath, MeshCacheHeader* header) {
+		std::ifstream file(cachePath, std::ios::binary);
+		return file.read((char*)header, sizeof(MeshCacheHeader)).good();
+	}
+
+	//Stores the source's new modified time after its contents were found unchanged, so later opens skip the hash.
+	//Called before the cache is mapped, since the mapping is read only
+	static void updateSourceModifiedTime(const std::string& cachePath, int64_t modifiedTime) {
+		std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+		if (!file.is_open()) {
+			return;
+		}
+		file.seekp(offsetof(MeshCacheHeader, sourceModifiedTime));
+		file.write((const char*)&modifiedTime, sizeof(modifiedTime));
+	}
+
+	static size_t alignOffset(size_t offset) {
+		return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1);
+	}
+
+	std::string getMeshCachePath(const std::string& sourcePath) {
+		return sourcePath + ".ewcache";
+	}
+
+	bool MeshCache::open(const std::string& cachePath, const std::string& sourcePath, uint32_t flags)
+	{
+		close();
+		MeshCacheHeader header;
+		if (!readHeader(cachePath, &header)) {
+			return false;
+		}
+		if (memcmp(header.magic, MESH_CACHE_MAGIC, 4) != 0 || header.version != MESH_CACHE_VERSION || header.flags != flags) {
+			return false;
+		}
+
+		//Cheap check first. If size or time differ, the file may just have been touched, so fall back to comparing contents
+		uint64_t sourceSize;
+		int64_t sourceModifiedTime;
+		if (!getSourceInfo(sourcePath, &sourceSize, &sourceModifiedTime)) {
+			return false;
+		}
+		if (sourceSize != header.sourceSize || sourceModifiedTime != header.sourceModifiedTime) {
+			uint64_t sourceHash;
+			if (sourceSize != header.sourceSize || !hashSourceFile(sourcePath, &sourceHash) || sourceHash != header.sourceHash) {
+				return false;
+			}
+			updateSourceModifiedTime(cachePath, sourceModifiedTime);
+			header.sourceModifiedTime = sourceModifiedTime;
+		}
+
+		if (!m_file.open(cachePath)) {
+			return false;
+		}
+		const unsigned char* data = m_file.getData();
+		size_t size = m_file.getSize();
+		//Another process may have replaced the cache since the header was read
+		if (size < sizeof(MeshCacheHeader) || memcmp(data, &header, sizeof(header)) != 0) {
+			close();
+			return false;
+		}
+
+		if (!isRangeInside(sizeof(MeshCacheHeader), header.numMeshes, sizeof(MeshCacheTableEntry), size)) {
+			close();
+			return false;
+		}
+		m_meshes.resize(header.numMeshes);
+		for (uint32_t i = 0; i < header.numMeshes; i++)
+		{
+			MeshCacheTableEntry tableEntry;
+			memcpy(&tableEntry, data + sizeof(MeshCacheHeader) + sizeof(MeshCacheTableEntry) * i, sizeof(tableEntry));
+			bool validIndexType = tableEntry.indexType == GL_UNSIGNED_SHORT || tableEntry.indexType == GL_UNSIGNED_INT;
+			size_t indexSize = tableEntry.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+			//writeMeshCache aligns every blob, which also makes the typed pointers below safe to read
+			bool aligned = tableEntry.verticesOffset % MESH_CACHE_ALIGNMENT == 0 && tableEntry.indicesOffset % MESH_CACHE_ALIGNMENT == 0;
+			bool valid = validIndexType && aligned
+				&& isRangeInside(tableEntry.verticesOffset, tableEntry.numVertices, sizeof(Vertex), size)
+				&& isRangeInside(tableEntry.indicesOffset, tableEntry.numIndices, indexSize, size);
+			if (valid) {
+				const unsigned char* indices = data + tableEntry.indicesOffset;
+				valid = tableEntry.indexType == GL_UNSIGNED_SHORT
+					? areIndicesInside((const uint16_t*)indices, tableEntry.numIndices, tableEntry.numVertices)
+					: areIndicesInside((const uint32_t*)indices, tableEntry.numIndices, tableEntry.numVertices);
+			}
+			if (!valid) {
+				printf("Mesh cache %s is corrupt\n", cachePath.c_str());
+				close();
+				return false;
+			}
+			MeshCacheEntry& entry = m_meshes[i];
+			entry.vertices = (const Vertex*)(data + tableEntry.verticesOffset);
+			entry.numVertices = tableEntry.numVertices;
+			entry.indices = data + tableEntry.indicesOffset;
+			entry.numIndices = tableEntry.numIndices;
+			entry.indexType = tableEntry.indexType;
+		}
+		return true;
+	}
+
+	void MeshCache::close()
+	{
+		m_meshes.clear();
+		m_file.close();
+	}
+
+	/// <summary>
+	/// Writes processed meshes to a cache file, tagged with the source file's size, time and hash
+	/// </summary>
+	/// <returns>False if the source can't be read or the cache can't be written</returns>
+	bool writeMeshCache(const std::string& cachePath, const std::string& sourcePath, uint32_t flags, const std::vector<MeshData>& meshes) {
+		MeshCacheHeader header;
+		memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+		header.version = MESH_CACHE_VERSION;
+		header.flags = flags;
+		header.numMeshes = meshes.size();
+		if (!getSourceInfo(sourcePath, &header.sourceSize, &header.sourceModifiedTime) || !hashSourceFile(sourcePath, &header.sourceHash)) {
+			return false;
+		}
+
+		//Lay out blobs after the table
+		std::vector<MeshCacheTableEntry> table(meshes.size());
+		size_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheTableEntry) * meshes.size();
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			MeshCacheTableEntry& entry = table[i];
+			entry.numVertices = meshes[i].vertices.size();
+			entry.numIndices = meshes[i].indices.size();
+			entry.indexType = entry.numVertices <= MAX_16BIT_INDEX_VERTICES ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+			entry.padding = 0;
+			offset = alignOffset(offset);
+			entry.verticesOffset = offset;
+			offset += sizeof(Vertex) * (size_t)entry.numVertices;
+			offset = alignOffset(offset);
+			entry.indicesOffset = offset;
+			offset += (entry.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)) * (size_t)entry.numIndices;
+		}
+
+		//Write to a temporary file and rename, so a crash never leaves a half written cache behind
+		std::string tempPath = getTempFilePath(cachePath);
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) {
+				return false;
+			}
+			const char zeros[MESH_CACHE_ALIGNMENT] = {};
+			size_t written = 0;
+			auto writeAt = [&](size_t position, const void* bytes, size_t count) {
+				out.write(zeros, position - written);
+				out.write((const char*)bytes, count);
+				written = position + count;
+			};
+			writeAt(0, &header, sizeof(header));
+			writeAt(written, table.data(), sizeof(MeshCacheTableEntry) * table.size());
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				writeAt(table[i].verticesOffset, meshes[i].vertices.data(), sizeof(Vertex) * meshes[i].vertices.size());
+				if (table[i].indexType == GL_UNSIGNED_SHORT) {
+					std::vector<uint16_t> shortIndices(meshes[i].indices.begin(), meshes[i].indices.end());
+					writeAt(table[i].indicesOffset, shortIndices.data(), sizeof(uint16_t) * shortIndices.size());
+				}
+				else {
+					writeAt(table[i].indicesOffset, meshes[i].indices.data(), sizeof(uint32_t) * meshes[i].indices.size());
+				}
+			}
+			if (!out.good()) {
+				out.close();
+				remove(tempPath.c_str());
+				return false;
+			}
+		}
+		remove(cachePath.c_str());
+		if (rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+			//Another writer got there between remove and rename. Its cache holds the same data
+			remove(tempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
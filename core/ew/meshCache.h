@@ -0,0 +1,57 @@
+#pragma once
+#include "mesh.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ew {
+	//Bump whenever the file layout or Vertex changes. Caches with another version are rebuilt
+	const uint32_t MESH_CACHE_VERSION = 1;
+
+	//Read-only memory mapping of a whole file
+	class MappedFile {
+	public:
+		MappedFile() {};
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		bool open(const std::string& filePath);
+		void close();
+		inline const unsigned char* getData()const { return m_data; }
+		inline size_t getSize()const { return m_size; }
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_fileHandle = nullptr;
+		void* m_mappingHandle = nullptr;
+#endif
+	};
+
+	//A mesh stored in the cache. Pointers point into the mapping and stay valid while the MeshCache is open
+	struct MeshCacheEntry {
+		const Vertex* vertices = nullptr;
+		unsigned int numVertices = 0;
+		const void* indices = nullptr;
+		unsigned int numIndices = 0;
+		unsigned int indexType = 0; //GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, chosen the same way as Mesh::load
+	};
+
+	//Binary cache of processed mesh data for one source asset.
+	//Layout: header, mesh table, then 16 byte aligned vertex and index blobs.
+	class MeshCache {
+	public:
+		//Maps the cache and validates it against the source file. flags identify load options that change the mesh data.
+		//Returns false if the cache is missing, corrupt, from another version or stale.
+		bool open(const std::string& cachePath, const std::string& sourcePath, uint32_t flags);
+		void close();
+		inline unsigned int getNumMeshes()const { return m_meshes.size(); }
+		inline const MeshCacheEntry& getMesh(unsigned int i)const { return m_meshes[i]; }
+	private:
+		MappedFile m_file;
+		std::vector<MeshCacheEntry> m_meshes;
+	};
+
+	bool writeMeshCache(const std::string& cachePath, const std::string& sourcePath, uint32_t flags, const std::vector<MeshData>& meshes);
+	std::string getMeshCachePath(const std::string& sourcePath);
+}
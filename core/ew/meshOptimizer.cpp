@@ -0,0 +1,273 @@
+#include "meshOptimizer.h"
+#include <vector>
+#include <cmath>
+#include <stdio.h>
+
+namespace ew {
+	/// <summary>
+	/// Simulates a FIFO post-transform cache of a given size over the mesh's triangle list.
+	/// Useful for measuring the effect of optimizeVertexCache without a GPU.
+	/// </summary>
+	/// <param name="meshData">Triangle list to analyze</param>
+	/// <param name="cacheSize">Number of entries in the simulated cache</param>
+	/// <returns></returns>
+	VertexCacheStats analyzeVertexCache(const MeshData& meshData, unsigned int cacheSize) {
+		VertexCacheStats stats;
+		stats.numTriangles = meshData.indices.size() / 3;
+		if (stats.numTriangles == 0 || cacheSize == 0) {
+			return stats;
+		}
+		//Timestamp of when each vertex entered the cache. A vertex is cached while (time - timestamp) < cacheSize
+		std::vector<unsigned int> cacheTimestamps(meshData.vertices.size(), 0);
+		std::vector<bool> referenced(meshData.vertices.size(), false);
+		unsigned int time = cacheSize + 1;
+		for (size_t i = 0; i < stats.numTriangles * 3; i++)
+		{
+			unsigned int index = meshData.indices[i];
+			if (index >= meshData.vertices.size()) {
+				continue;
+			}
+			if (time - cacheTimestamps[index] > cacheSize) {
+				cacheTimestamps[index] = time++;
+				stats.cacheMisses++;
+			}
+			if (!referenced[index]) {
+				referenced[index] = true;
+				stats.numVertices++;
+			}
+		}
+		stats.acmr = (float)stats.cacheMisses / stats.numTriangles;
+		stats.atvr = stats.numVertices > 0 ? (float)stats.cacheMisses / stats.numVertices : 0.0f;
+		return stats;
+	}
+
+	//Tunables for the Forsyth scoring function
+	static const int FORSYTH_CACHE_SIZE = 32;
+	static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	static const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+	static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	/// <summary>
+	/// Score of a vertex given its position in the simulated LRU cache and how many unemitted triangles still use it
+	/// </summary>
+	static float forsythVertexScore(int cachePosition, unsigned int remainingValence) {
+		if (remainingValence == 0) {
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				//Vertices of the last triangle get a fixed score so the next triangle doesn't just reuse the same edge
+				score = FORSYTH_LAST_TRI_SCORE;
+			}
+			else {
+				float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+		//Boost vertices with few remaining triangles so that lone triangles get cleared out
+		score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingValence, -FORSYTH_VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	/// <summary>
+	/// Reorders triangles to maximize post-transform vertex cache hits, using Tom Forsyth's linear-speed algorithm.
+	/// Vertex data is untouched.
+	/// </summary>
+	/// <param name="meshData">Triangle list to reorder in place</param>
+	void optimizeVertexCache(MeshData* meshData) {
+		const size_t numVertices = meshData->vertices.size();
+		const size_t numTriangles = meshData->indices.size() / 3;
+		if (numTriangles == 0 || numVertices == 0) {
+			return;
+		}
+		const std::vector<unsigned int>& indices = meshData->indices;
+		for (size_t i = 0; i < numTriangles * 3; i++)
+		{
+			if (indices[i] >= numVertices) {
+				printf("optimizeVertexCache: index %u out of range, skipping\n", indices[i]);
+				return;
+			}
+		}
+
+		//Build vertex -> triangle adjacency as a flat list with per-vertex offsets
+		std::vector<unsigned int> valence(numVertices, 0);
+		for (size_t i = 0; i < numTriangles * 3; i++)
+		{
+			valence[indices[i]]++;
+		}
+		std::vector<unsigned int> adjacencyOffsets(numVertices + 1, 0);
+		for (size_t i = 0; i < numVertices; i++)
+		{
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + valence[i];
+		}
+		std::vector<unsigned int> adjacency(numTriangles * 3);
+		{
+			std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < numTriangles * 3; i++)
+			{
+				adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+			}
+		}
+
+		//Per vertex state
+		std::vector<int> cachePosition(numVertices, -1);
+		std::vector<float> vertexScore(numVertices);
+		for (size_t i = 0; i < numVertices; i++)
+		{
+			vertexScore[i] = forsythVertexScore(-1, valence[i]);
+		}
+
+		//Per triangle state
+		std::vector<float> triangleScore(numTriangles);
+		std::vector<bool> emitted(numTriangles, false);
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		}
+
+		//Simulated LRU cache. Extra 3 slots hold vertices pushed out by the newest triangle
+		int cache[FORSYTH_CACHE_SIZE + 3];
+		int cacheCount = 0;
+
+		std::vector<unsigned int> newIndices;
+		newIndices.reserve(numTriangles * 3);
+
+		size_t scanCursor = 0;
+		int bestTriangle = -1;
+		for (size_t emittedCount = 0; emittedCount < numTriangles; emittedCount++)
+		{
+			//No candidate from the cache, fall back to the next unemitted triangle in input order
+			if (bestTriangle < 0) {
+				while (emitted[scanCursor]) {
+					scanCursor++;
+				}
+				bestTriangle = (int)scanCursor;
+			}
+
+			const unsigned int* tri = &indices[bestTriangle * 3];
+			newIndices.push_back(tri[0]);
+			newIndices.push_back(tri[1]);
+			newIndices.push_back(tri[2]);
+			emitted[bestTriangle] = true;
+
+			//Remove the triangle from its vertices' adjacency lists
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = tri[k];
+				unsigned int* adj = &adjacency[adjacencyOffsets[v]];
+				for (unsigned int a = 0; a < valence[v]; a++)
+				{
+					if (adj[a] == (unsigned int)bestTriangle) {
+						adj[a] = adj[valence[v] - 1];
+						break;
+					}
+				}
+				valence[v]--;
+			}
+
+			//Push the triangle's vertices to the front of the cache
+			int newCache[FORSYTH_CACHE_SIZE + 3];
+			int newCount = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				newCache[newCount++] = (int)tri[k];
+			}
+			for (int c = 0; c < cacheCount; c++)
+			{
+				int v = cache[c];
+				if (v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2]) {
+					newCache[newCount++] = v;
+				}
+			}
+			cacheCount = newCount;
+			for (int c = 0; c < cacheCount; c++)
+			{
+				cache[c] = newCache[c];
+			}
+
+			//Rescore every vertex that was touched
+			for (int c = 0; c < cacheCount; c++)
+			{
+				int v = cache[c];
+				cachePosition[v] = c < FORSYTH_CACHE_SIZE ? c : -1;
+				float newScore = forsythVertexScore(cachePosition[v], valence[v]);
+				float delta = newScore - vertexScore[v];
+				vertexScore[v] = newScore;
+				const unsigned int* adj = &adjacency[adjacencyOffsets[v]];
+				for (unsigned int a = 0; a < valence[v]; a++)
+				{
+					triangleScore[adj[a]] += delta;
+				}
+			}
+			//The next triangle is the best scoring one that uses a cached vertex
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (int c = 0; c < cacheCount && c < FORSYTH_CACHE_SIZE; c++)
+			{
+				int v = cache[c];
+				const unsigned int* adj = &adjacency[adjacencyOffsets[v]];
+				for (unsigned int a = 0; a < valence[v]; a++)
+				{
+					unsigned int t = adj[a];
+					if (triangleScore[t] > bestScore) {
+						bestScore = triangleScore[t];
+						bestTriangle = (int)t;
+					}
+				}
+			}
+			if (cacheCount > FORSYTH_CACHE_SIZE) {
+				cacheCount = FORSYTH_CACHE_SIZE;
+			}
+		}
+		//Keep any trailing indices that don't form a full triangle
+		for (size_t i = numTriangles * 3; i < indices.size(); i++)
+		{
+			newIndices.push_back(indices[i]);
+		}
+		meshData->indices.swap(newIndices);
+	}
+
+	/// <summary>
+	/// Reorders vertices in the order they are first referenced by the index buffer, so that vertex fetch is mostly sequential.
+	/// Vertices not referenced by any triangle are kept at the end.
+	/// Run after optimizeVertexCache.
+	/// </summary>
+	/// <param name="meshData">Mesh to reorder in place</param>
+	void optimizeVertexFetch(MeshData* meshData) {
+		const unsigned int unmapped = 0xFFFFFFFF;
+		const size_t numVertices = meshData->vertices.size();
+		std::vector<unsigned int> remap(numVertices, unmapped);
+		std::vector<Vertex> newVertices;
+		newVertices.reserve(numVertices);
+		for (size_t i = 0; i < meshData->indices.size(); i++)
+		{
+			unsigned int& index = meshData->indices[i];
+			if (index >= numVertices) {
+				continue;
+			}
+			if (remap[index] == unmapped) {
+				remap[index] = (unsigned int)newVertices.size();
+				newVertices.push_back(meshData->vertices[index]);
+			}
+			index = remap[index];
+		}
+		for (size_t i = 0; i < numVertices; i++)
+		{
+			if (remap[i] == unmapped) {
+				newVertices.push_back(meshData->vertices[i]);
+			}
+		}
+		meshData->vertices.swap(newVertices);
+	}
+
+	/// <summary>
+	/// Runs all optimization passes on the mesh in the correct order
+	/// </summary>
+	/// <param name="meshData">Mesh to optimize in place</param>
+	void optimizeMesh(MeshData* meshData) {
+		optimizeVertexCache(meshData);
+		optimizeVertexFetch(meshData);
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	//Results of simulating a FIFO post-transform vertex cache over an index buffer
+	struct VertexCacheStats {
+		unsigned int numTriangles = 0;
+		unsigned int numVertices = 0; //Unique vertices referenced by the index buffer
+		unsigned int cacheMisses = 0; //Number of vertex shader invocations
+		float acmr = 0.0f; //Average cache miss ratio. Misses per triangle, 0.5 is ideal, 3.0 is worst case
+		float atvr = 0.0f; //Average transformed vertex ratio. Misses per unique vertex, 1.0 is ideal
+	};
+
+	VertexCacheStats analyzeVertexCache(const MeshData& meshData, unsigned int cacheSize = 16);
+	void optimizeVertexCache(MeshData* meshData);
+	void optimizeVertexFetch(MeshData* meshData);
+	void optimizeMesh(MeshData* meshData);
+}
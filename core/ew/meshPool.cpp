@@ -0,0 +1,382 @@
+#include "meshPool.h"
+#include "glState.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <stdio.h>
+
+namespace ew {
+	FreeListAllocator::FreeListAllocator(unsigned int capacity)
+	{
+		reset(capacity, 0);
+	}
+
+	/// <summary>
+	/// Finds the first free block that fits and takes size elements from its start
+	/// </summary>
+	/// <returns>Offset of the allocation, or INVALID_OFFSET if no block is large enough</returns>
+	unsigned int FreeListAllocator::allocate(unsigned int size)
+	{
+		if (size == 0) {
+			return INVALID_OFFSET;
+		}
+		for (size_t i = 0; i < m_freeBlocks.size(); i++)
+		{
+			Block& block = m_freeBlocks[i];
+			if (block.size >= size) {
+				unsigned int offset = block.offset;
+				block.offset += size;
+				block.size -= size;
+				if (block.size == 0) {
+					m_freeBlocks.erase(m_freeBlocks.begin() + i);
+				}
+				m_used += size;
+				return offset;
+			}
+		}
+		return INVALID_OFFSET;
+	}
+
+	/// <summary>
+	/// Returns a range to the free list, merging it with neighboring free blocks
+	/// </summary>
+	void FreeListAllocator::release(unsigned int offset, unsigned int size)
+	{
+		if (size == 0) {
+			return;
+		}
+		auto it = std::lower_bound(m_freeBlocks.begin(), m_freeBlocks.end(), offset,
+			[](const Block& block, unsigned int o) { return block.offset < o; });
+		it = m_freeBlocks.insert(it, Block{ offset, size });
+		m_used -= size;
+		//Merge with next
+		auto next = it + 1;
+		if (next != m_freeBlocks.end() && it->offset + it->size == next->offset) {
+			it->size += next->size;
+			m_freeBlocks.erase(next);
+		}
+		//Merge with previous
+		if (it != m_freeBlocks.begin()) {
+			auto prev = it - 1;
+			if (prev->offset + prev->size == it->offset) {
+				prev->size += it->size;
+				m_freeBlocks.erase(it);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Extends the managed range. The new space is appended to the free list
+	/// </summary>
+	void FreeListAllocator::grow(unsigned int newCapacity)
+	{
+		if (newCapacity <= m_capacity) {
+			return;
+		}
+		unsigned int oldCapacity = m_capacity;
+		m_capacity = newCapacity;
+		//release() counts the new space as used being freed, so account for it first
+		m_used += newCapacity - oldCapacity;
+		release(oldCapacity, newCapacity - oldCapacity);
+	}
+
+	/// <summary>
+	/// Treats [0, used) as allocated and [used, capacity) as one free block
+	/// </summary>
+	void FreeListAllocator::reset(unsigned int capacity, unsigned int used)
+	{
+		m_capacity = capacity;
+		m_used = used;
+		m_freeBlocks.clear();
+		if (capacity > used) {
+			m_freeBlocks.push_back(Block{ used, capacity - used });
+		}
+	}
+
+	unsigned int FreeListAllocator::getLargestFreeBlock() const
+	{
+		unsigned int largest = 0;
+		for (size_t i = 0; i < m_freeBlocks.size(); i++)
+		{
+			largest = std::max(largest, m_freeBlocks[i].size);
+		}
+		return largest;
+	}
+
+	//Creates a buffer of the given size, copying copySize bytes from an existing buffer if one is given
+	static unsigned int createBuffer(size_t size, unsigned int copyFrom, size_t copySize) {
+		unsigned int buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+		if (copyFrom != 0 && copySize > 0) {
+			glBindBuffer(GL_COPY_READ_BUFFER, copyFrom);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, copySize);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		return buffer;
+	}
+
+	MeshPool::MeshPool(unsigned int vertexCapacity, unsigned int indexCapacity)
+		: m_vertexAllocator(vertexCapacity), m_indexAllocator(indexCapacity)
+	{
+		glGenVertexArrays(1, &m_vao);
+		setBuffers(createBuffer(sizeof(Vertex) * (size_t)vertexCapacity, 0, 0),
+			createBuffer(sizeof(unsigned int) * (size_t)indexCapacity, 0, 0));
+	}
+
+	MeshPool::~MeshPool()
+	{
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		glDeleteVertexArrays(1, &m_vao);
+		GLState::vertexArrayDeleted(m_vao);
+	}
+
+	/// <summary>
+	/// Replaces the pool's buffers, deleting the old ones, and points the VAO at the new ones
+	/// </summary>
+	void MeshPool::setBuffers(unsigned int vbo, unsigned int ebo)
+	{
+		if (m_vbo != 0 && m_vbo != vbo) {
+			glDeleteBuffers(1, &m_vbo);
+		}
+		if (m_ebo != 0 && m_ebo != ebo) {
+			glDeleteBuffers(1, &m_ebo);
+		}
+		m_vbo = vbo;
+		m_ebo = ebo;
+
+		GLState::bindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		//Position attribute
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
+		glEnableVertexAttribArray(0);
+		//Normal attribute
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
+		glEnableVertexAttribArray(1);
+		//UV attribute
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, uv));
+		glEnableVertexAttribArray(2);
+		GLState::bindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void MeshPool::growVertices(unsigned int minCapacity)
+	{
+		unsigned int oldCapacity = m_vertexAllocator.getCapacity();
+		unsigned int newCapacity = std::max(minCapacity, oldCapacity * 2);
+		unsigned int vbo = createBuffer(sizeof(Vertex) * (size_t)newCapacity, m_vbo, sizeof(Vertex) * (size_t)oldCapacity);
+		m_vertexAllocator.grow(newCapacity);
+		setBuffers(vbo, m_ebo);
+		m_numGrows++;
+	}
+
+	void MeshPool::growIndices(unsigned int minCapacity)
+	{
+		unsigned int oldCapacity = m_indexAllocator.getCapacity();
+		unsigned int newCapacity = std::max(minCapacity, oldCapacity * 2);
+		unsigned int ebo = createBuffer(sizeof(unsigned int) * (size_t)newCapacity, m_ebo, sizeof(unsigned int) * (size_t)oldCapacity);
+		m_indexAllocator.grow(newCapacity);
+		setBuffers(m_vbo, ebo);
+		m_numGrows++;
+	}
+
+	/// <summary>
+	/// Copies mesh data into the shared buffers, growing them if there is no free block large enough
+	/// </summary>
+	/// <param name="meshData">Mesh to add. Indices are relative to the mesh's first vertex</param>
+	/// <returns>Handle used to draw or remove the mesh</returns>
+	MeshPoolHandle MeshPool::add(const MeshData& meshData)
+	{
+		return add(meshData.vertices.data(), meshData.vertices.size(), meshData.indices.data(), meshData.indices.size());
+	}
+
+	MeshPoolHandle MeshPool::add(const Vertex* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
+	{
+		unsigned int vertexOffset = m_vertexAllocator.allocate(numVertices);
+		if (vertexOffset == FreeListAllocator::INVALID_OFFSET && numVertices > 0) {
+			growVertices(m_vertexAllocator.getCapacity() + numVertices);
+			vertexOffset = m_vertexAllocator.allocate(numVertices);
+		}
+		unsigned int indexOffset = m_indexAllocator.allocate(numIndices);
+		if (indexOffset == FreeListAllocator::INVALID_OFFSET && numIndices > 0) {
+			growIndices(m_indexAllocator.getCapacity() + numIndices);
+			indexOffset = m_indexAllocator.allocate(numIndices);
+		}
+
+		if (numVertices > 0) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * (size_t)vertexOffset, sizeof(Vertex) * (size_t)numVertices, vertices);
+		}
+		if (numIndices > 0) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * (size_t)indexOffset, sizeof(unsigned int) * (size_t)numIndices, indices);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		unsigned int slotIndex;
+		if (!m_freeSlots.empty()) {
+			slotIndex = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else {
+			slotIndex = m_slots.size();
+			m_slots.emplace_back();
+		}
+		Slot& slot = m_slots[slotIndex];
+		slot.alive = true;
+		slot.range.baseVertex = numVertices > 0 ? (int)vertexOffset : 0;
+		slot.range.firstIndex = numIndices > 0 ? indexOffset : 0;
+		slot.range.numVertices = numVertices;
+		slot.range.numIndices = numIndices;
+		m_numMeshes++;
+
+		MeshPoolHandle handle;
+		handle.slot = slotIndex;
+		handle.generation = slot.generation;
+		return handle;
+	}
+
+	/// <summary>
+	/// Frees the mesh's space in the shared buffers. The handle becomes invalid.
+	/// </summary>
+	void MeshPool::remove(MeshPoolHandle handle)
+	{
+		if (!isValid(handle)) {
+			printf("MeshPool: tried to remove an invalid handle\n");
+			return;
+		}
+		Slot& slot = m_slots[handle.slot];
+		m_vertexAllocator.release(slot.range.baseVertex, slot.range.numVertices);
+		m_indexAllocator.release(slot.range.firstIndex, slot.range.numIndices);
+		slot.alive = false;
+		slot.generation++;
+		slot.range = MeshPoolRange();
+		m_freeSlots.push_back(handle.slot);
+		m_numMeshes--;
+	}
+
+	bool MeshPool::isValid(MeshPoolHandle handle) const
+	{
+		return handle.slot < m_slots.size() && m_slots[handle.slot].alive && m_slots[handle.slot].generation == handle.generation;
+	}
+
+	const MeshPoolRange& MeshPool::getRange(MeshPoolHandle handle) const
+	{
+		static const MeshPoolRange emptyRange;
+		if (!isValid(handle)) {
+			return emptyRange;
+		}
+		return m_slots[handle.slot].range;
+	}
+
+	void MeshPool::bind() const
+	{
+		GLState::bindVertexArray(m_vao);
+	}
+
+	void MeshPool::draw(MeshPoolHandle handle) const
+	{
+		const MeshPoolRange& range = getRange(handle);
+		if (range.numIndices == 0) {
+			return;
+		}
+		glDrawElementsBaseVertex(GL_TRIANGLES, range.numIndices, GL_UNSIGNED_INT,
+			(const void*)(sizeof(unsigned int) * (size_t)range.firstIndex), range.baseVertex);
+	}
+
+	void MeshPool::drawInstanced(MeshPoolHandle handle, unsigned int instanceCount) const
+	{
+		const MeshPoolRange& range = getRange(handle);
+		if (range.numIndices == 0) {
+			return;
+		}
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.numIndices, GL_UNSIGNED_INT,
+			(const void*)(sizeof(unsigned int) * (size_t)range.firstIndex), instanceCount, range.baseVertex);
+	}
+
+	/// <summary>
+	/// Copies every live mesh into fresh buffers, packed in their current order.
+	/// Handles stay valid; ranges returned by getRange() change.
+	/// </summary>
+	void MeshPool::defragment()
+	{
+		std::vector<unsigned int> live;
+		live.reserve(m_numMeshes);
+		for (size_t i = 0; i < m_slots.size(); i++)
+		{
+			if (m_slots[i].alive) {
+				live.push_back(i);
+			}
+		}
+
+		unsigned int vertexCapacity = m_vertexAllocator.getCapacity();
+		unsigned int indexCapacity = m_indexAllocator.getCapacity();
+		unsigned int vbo = createBuffer(sizeof(Vertex) * (size_t)vertexCapacity, 0, 0);
+		unsigned int ebo = createBuffer(sizeof(unsigned int) * (size_t)indexCapacity, 0, 0);
+
+		//Vertices, in order of current offset so data moves toward the front
+		std::sort(live.begin(), live.end(), [this](unsigned int a, unsigned int b) {
+			return m_slots[a].range.baseVertex < m_slots[b].range.baseVertex;
+		});
+		glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+		unsigned int vertexCursor = 0;
+		for (size_t i = 0; i < live.size(); i++)
+		{
+			MeshPoolRange& range = m_slots[live[i]].range;
+			if (range.numVertices > 0) {
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+					sizeof(Vertex) * (size_t)range.baseVertex, sizeof(Vertex) * (size_t)vertexCursor, sizeof(Vertex) * (size_t)range.numVertices);
+			}
+			range.baseVertex = (int)vertexCursor;
+			vertexCursor += range.numVertices;
+		}
+
+		//Indices. Values are relative to baseVertex so they can be copied as is
+		std::sort(live.begin(), live.end(), [this](unsigned int a, unsigned int b) {
+			return m_slots[a].range.firstIndex < m_slots[b].range.firstIndex;
+		});
+		glBindBuffer(GL_COPY_READ_BUFFER, m_ebo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+		unsigned int indexCursor = 0;
+		for (size_t i = 0; i < live.size(); i++)
+		{
+			MeshPoolRange& range = m_slots[live[i]].range;
+			if (range.numIndices > 0) {
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+					sizeof(unsigned int) * (size_t)range.firstIndex, sizeof(unsigned int) * (size_t)indexCursor, sizeof(unsigned int) * (size_t)range.numIndices);
+			}
+			range.firstIndex = indexCursor;
+			indexCursor += range.numIndices;
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		m_vertexAllocator.reset(vertexCapacity, vertexCursor);
+		m_indexAllocator.reset(indexCapacity, indexCursor);
+		setBuffers(vbo, ebo);
+		m_numDefragments++;
+	}
+
+	MeshPoolStats MeshPool::getStats() const
+	{
+		MeshPoolStats stats;
+		stats.numMeshes = m_numMeshes;
+		stats.vertexCapacity = m_vertexAllocator.getCapacity();
+		stats.verticesUsed = m_vertexAllocator.getUsed();
+		stats.indexCapacity = m_indexAllocator.getCapacity();
+		stats.indicesUsed = m_indexAllocator.getUsed();
+		stats.numFreeVertexBlocks = m_vertexAllocator.getNumFreeBlocks();
+		stats.numFreeIndexBlocks = m_indexAllocator.getNumFreeBlocks();
+		stats.largestFreeVertexBlock = m_vertexAllocator.getLargestFreeBlock();
+		stats.largestFreeIndexBlock = m_indexAllocator.getLargestFreeBlock();
+		stats.numGrows = m_numGrows;
+		stats.numDefragments = m_numDefragments;
+		stats.bytesAllocated = sizeof(Vertex) * (size_t)stats.vertexCapacity + sizeof(unsigned int) * (size_t)stats.indexCapacity;
+		stats.bytesUsed = sizeof(Vertex) * (size_t)stats.verticesUsed + sizeof(unsigned int) * (size_t)stats.indicesUsed;
+		return stats;
+	}
+}
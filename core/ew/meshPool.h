@@ -0,0 +1,108 @@
+#pragma once
+#include "mesh.h"
+#include <vector>
+
+namespace ew {
+	//First fit allocator over a range of elements. Free blocks are kept sorted by offset and merged on release.
+	class FreeListAllocator {
+	public:
+		static const unsigned int INVALID_OFFSET = 0xFFFFFFFF;
+		FreeListAllocator(unsigned int capacity = 0);
+		unsigned int allocate(unsigned int size);
+		void release(unsigned int offset, unsigned int size);
+		void grow(unsigned int newCapacity);
+		void reset(unsigned int capacity, unsigned int used);
+		inline unsigned int getCapacity()const { return m_capacity; }
+		inline unsigned int getUsed()const { return m_used; }
+		inline unsigned int getNumFreeBlocks()const { return m_freeBlocks.size(); }
+		unsigned int getLargestFreeBlock()const;
+	private:
+		struct Block {
+			unsigned int offset;
+			unsigned int size;
+		};
+		std::vector<Block> m_freeBlocks;
+		unsigned int m_capacity = 0;
+		unsigned int m_used = 0;
+	};
+
+	//Identifies a mesh in a MeshPool. Generation guards against using a handle after its mesh was removed.
+	struct MeshPoolHandle {
+		unsigned int slot = 0xFFFFFFFF;
+		unsigned int generation = 0;
+	};
+
+	//Where a mesh lives in the pool's shared buffers. Indices are relative to baseVertex.
+	struct MeshPoolRange {
+		int baseVertex = 0;
+		unsigned int firstIndex = 0;
+		unsigned int numIndices = 0;
+		unsigned int numVertices = 0;
+	};
+
+	struct MeshPoolStats {
+		unsigned int numMeshes = 0;
+		unsigned int vertexCapacity = 0;
+		unsigned int verticesUsed = 0;
+		unsigned int indexCapacity = 0;
+		unsigned int indicesUsed = 0;
+		unsigned int numFreeVertexBlocks = 0;
+		unsigned int numFreeIndexBlocks = 0;
+		unsigned int largestFreeVertexBlock = 0;
+		unsigned int largestFreeIndexBlock = 0;
+		unsigned int numGrows = 0;
+		unsigned int numDefragments = 0;
+		size_t bytesAllocated = 0; //GPU memory owned by the pool
+		size_t bytesUsed = 0; //GPU memory holding live mesh data
+	};
+
+	//Geometry arena. Every mesh's vertices and indices are sub-allocated from one VBO and one EBO
+	//sharing a single VAO, so many meshes can be drawn with a single bind.
+	//Vertices use the STANDARD layout and indices are 32 bit.
+	class MeshPool {
+	public:
+		MeshPool(unsigned int vertexCapacity = 65536, unsigned int indexCapacity = 262144);
+		~MeshPool();
+		MeshPool(const MeshPool&) = delete;
+		MeshPool& operator=(const MeshPool&) = delete;
+
+		MeshPoolHandle add(const MeshData& meshData);
+		MeshPoolHandle add(const Vertex* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices);
+		void remove(MeshPoolHandle handle);
+		bool isValid(MeshPoolHandle handle)const;
+		const MeshPoolRange& getRange(MeshPoolHandle handle)const;
+
+		//Binds the shared VAO. Call once before any number of draw() calls
+		void bind()const;
+		//Draws a mesh from the pool. Expects bind() to have been called
+		void draw(MeshPoolHandle handle)const;
+		void drawInstanced(MeshPoolHandle handle, unsigned int instanceCount)const;
+		//Packs all live meshes to the start of the buffers, leaving one free block at the end of each
+		void defragment();
+		MeshPoolStats getStats()const;
+
+		inline unsigned int getVAO()const { return m_vao; }
+		inline unsigned int getVBO()const { return m_vbo; }
+		inline unsigned int getEBO()const { return m_ebo; }
+	private:
+		struct Slot {
+			MeshPoolRange range;
+			unsigned int generation = 0;
+			bool alive = false;
+		};
+		void setBuffers(unsigned int vbo, unsigned int ebo);
+		void growVertices(unsigned int minCapacity);
+		void growIndices(unsigned int minCapacity);
+
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		FreeListAllocator m_vertexAllocator;
+		FreeListAllocator m_indexAllocator;
+		std::vector<Slot> m_slots;
+		std::vector<unsigned int> m_freeSlots;
+		unsigned int m_numMeshes = 0;
+		unsigned int m_numGrows = 0;
+		unsigned int m_numDefragments = 0;
+	};
+}
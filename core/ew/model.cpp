@@ -3,62 +3,378 @@
 */
 
 #include "model.h"
+#include "meshOptimizer.h"
+#include "threadPool.h"
+#include "glState.h"
+#include "external/glad.h"
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
 #include <assimp/scene.h>
 #include <glm/glm.hpp>
+#include <stdio.h>
 
 namespace ew {
-	ew::Mesh processAiMesh(aiMesh* aiMesh);
+	ew::MeshData processAiMesh(aiMesh* aiMesh);
+	void processMeshData(ew::MeshData meshData, const ModelLoadOptions& options, std::vector<ew::MeshData>* processed);
+	uint32_t getMeshCacheFlags(const ModelLoadOptions& options);
+	bool importModelData(const std::string& filePath, const ModelLoadOptions& options, std::vector<ew::MeshData>* meshes);
 
-	Model::Model(const std::string& filePath)
+	Model::Model(const std::string& filePath, const ModelLoadOptions& options)
 	{
+		m_meshPool = options.meshPool;
+		if (options.useMeshCache && loadFromCache(filePath, options)) {
+			return;
+		}
+		std::vector<ew::MeshData> meshes;
+		if (!importModelData(filePath, options, &meshes)) {
+			return;
+		}
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			addMesh(meshes[i], options);
+		}
+	}
+
+	/// <summary>
+	/// Imports a model file with Assimp and applies load options, writing the mesh cache if enabled. Makes no GL calls.
+	/// </summary>
+	/// <returns>False if the file could not be imported</returns>
+	bool importModelData(const std::string& filePath, const ModelLoadOptions& options, std::vector<ew::MeshData>* meshes) {
 		Assimp::Importer importer;
 		const aiScene* aiScene = importer.ReadFile(filePath, aiProcess_Triangulate);
-		for (size_t i = 0; i < aiScene->mNumMeshes; i++)
+		if (aiScene == NULL) {
+			printf("Failed to load model %s: %s\n", filePath.c_str(), importer.GetErrorString());
+			return false;
+		}
+		//Convert and process every aiMesh in parallel. Uploads happen later, since GL calls must stay on the context thread
+		std::vector<std::vector<ew::MeshData>> converted(aiScene->mNumMeshes);
+		ew::ThreadPool::getShared().parallelFor(aiScene->mNumMeshes, [&](size_t i) {
+			processMeshData(processAiMesh(aiScene->mMeshes[i]), options, &converted[i]);
+		});
+		for (size_t i = 0; i < converted.size(); i++)
 		{
-			aiMesh* aiMesh = aiScene->mMeshes[i];
-			m_meshes.push_back(processAiMesh(aiMesh));
+			for (size_t j = 0; j < converted[i].size(); j++)
+			{
+				meshes->push_back(std::move(converted[i][j]));
+			}
+		}
+		if (options.useMeshCache && !ew::writeMeshCache(ew::getMeshCachePath(filePath), filePath, getMeshCacheFlags(options), *meshes)) {
+			printf("Failed to write mesh cache for %s\n", filePath.c_str());
 		}
+		return true;
+	}
+
+	/// <summary>
+	/// Loads a model's processed meshes into memory, from the mesh cache if enabled and valid, otherwise by importing.
+	/// Makes no GL calls, so it can run on any thread.
+	/// </summary>
+	/// <returns>False if the file could not be loaded</returns>
+	bool loadModelData(const std::string& filePath, const ModelLoadOptions& options, std::vector<ew::MeshData>* meshes) {
+		if (options.useMeshCache) {
+			ew::MeshCache cache;
+			if (cache.open(ew::getMeshCachePath(filePath), filePath, getMeshCacheFlags(options))) {
+				meshes->resize(cache.getNumMeshes());
+				for (unsigned int i = 0; i < cache.getNumMeshes(); i++)
+				{
+					const ew::MeshCacheEntry& entry = cache.getMesh(i);
+					ew::MeshData& meshData = (*meshes)[i];
+					meshData.vertices.assign(entry.vertices, entry.vertices + entry.numVertices);
+					if (entry.indexType == GL_UNSIGNED_SHORT) {
+						const uint16_t* shortIndices = (const uint16_t*)entry.indices;
+						meshData.indices.assign(shortIndices, shortIndices + entry.numIndices);
+					}
+					else {
+						const unsigned int* intIndices = (const unsigned int*)entry.indices;
+						meshData.indices.assign(intIndices, intIndices + entry.numIndices);
+					}
+					meshData.bounds = ew::computeBounds(entry.vertices, entry.numVertices);
+				}
+				return true;
+			}
+		}
+		return importModelData(filePath, options, meshes);
+	}
+
+	/// <summary>
+	/// Uploads meshes straight from a memory mapped cache file
+	/// </summary>
+	/// <returns>False if there is no valid cache for this file and options</returns>
+	bool Model::loadFromCache(const std::string& filePath, const ModelLoadOptions& options)
+	{
+		ew::MeshCache cache;
+		if (!cache.open(ew::getMeshCachePath(filePath), filePath, getMeshCacheFlags(options))) {
+			return false;
+		}
+		for (unsigned int i = 0; i < cache.getNumMeshes(); i++)
+		{
+			addMesh(cache.getMesh(i), options);
+		}
+		return true;
 	}
 
 	void Model::draw()
 	{
+		if (m_meshPool) {
+			m_meshPool->bind();
+			for (size_t i = 0; i < m_poolMeshes.size(); i++)
+			{
+				m_meshPool->draw(m_poolMeshes[i]);
+			}
+			return;
+		}
 		for (size_t i = 0; i < m_meshes.size(); i++)
 		{
 			m_meshes[i].draw();
 		}
 	}
 
-	glm::vec3 convertAIVec3(const aiVector3D& v) {
-		return glm::vec3(v.x, v.y, v.z);
+	void Model::draw(const Shader& shader)
+	{
+		//Pooled meshes are never quantized
+		if (m_meshPool) {
+			draw();
+			return;
+		}
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			m_meshes[i].draw(shader);
+		}
+	}
+
+	unsigned int Model::draw(const Frustum& frustum, const glm::mat4& modelMatrix)
+	{
+		if (!isVisible(frustum, modelMatrix)) {
+			return 0;
+		}
+		//Single mesh models were already tested as a whole
+		bool testMeshes = m_meshBounds.size() > 1;
+		unsigned int numDrawn = 0;
+		if (m_meshPool) {
+			m_meshPool->bind();
+		}
+		for (size_t i = 0; i < getNumMeshes(); i++)
+		{
+			if (testMeshes && !ew::isVisible(frustum, transformSphere(m_meshBounds[i].sphere, modelMatrix))) {
+				continue;
+			}
+			if (m_meshPool) {
+				m_meshPool->draw(m_poolMeshes[i]);
+			}
+			else {
+				m_meshes[i].draw();
+			}
+			numDrawn++;
+		}
+		return numDrawn;
+	}
+
+	/// <summary>
+	/// Sphere test first since it is cheapest, then the tighter box test for objects near the frustum edges
+	/// </summary>
+	bool Model::isVisible(const Frustum& frustum, const glm::mat4& modelMatrix) const
+	{
+		if (!ew::isVisible(frustum, transformSphere(m_bounds.sphere, modelMatrix))) {
+			return false;
+		}
+		return ew::isVisible(frustum, transformAABB(m_bounds.aabb, modelMatrix));
+	}
+
+	void Model::unload()
+	{
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			m_meshes[i].unload();
+		}
+		m_meshes.clear();
+		if (m_meshPool) {
+			for (size_t i = 0; i < m_poolMeshes.size(); i++)
+			{
+				m_meshPool->remove(m_poolMeshes[i]);
+			}
+		}
+		m_poolMeshes.clear();
+		m_meshBounds.clear();
+		m_bounds = Bounds();
+	}
+
+	size_t Model::getGpuBytes() const
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			bytes += m_meshes[i].getGpuBytes();
+		}
+		if (m_meshPool) {
+			for (size_t i = 0; i < m_poolMeshes.size(); i++)
+			{
+				const MeshPoolRange& range = m_meshPool->getRange(m_poolMeshes[i]);
+				bytes += sizeof(Vertex) * range.numVertices + sizeof(unsigned int) * range.numIndices;
+			}
+		}
+		return bytes;
+	}
+
+	void Model::setInstanceBuffer(const InstanceBuffer* instanceBuffer)
+	{
+		if (m_meshPool) {
+			m_meshPool->bind();
+			instanceBuffer->bindAttributes();
+			GLState::bindVertexArray(0);
+			return;
+		}
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			m_meshes[i].setInstanceBuffer(instanceBuffer);
+		}
+	}
+
+	void Model::drawInstanced(unsigned int instanceCount)
+	{
+		if (m_meshPool) {
+			m_meshPool->bind();
+			for (size_t i = 0; i < m_poolMeshes.size(); i++)
+			{
+				m_meshPool->drawInstanced(m_poolMeshes[i], instanceCount);
+			}
+			return;
+		}
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			m_meshes[i].drawInstanced(instanceCount);
+		}
+	}
+
+	unsigned int Model::drawInstanced(const Frustum& frustum, InstanceBuffer* instanceBuffer, const glm::mat4* models, unsigned int count)
+	{
+		unsigned int numVisible = instanceBuffer->setVisibleData(frustum, m_bounds.sphere, models, count);
+		if (numVisible > 0) {
+			drawInstanced(numVisible);
+		}
+		return numVisible;
+	}
+
+	void Model::submit(BatchRenderer* batchRenderer, const glm::mat4& model) const
+	{
+		for (size_t i = 0; i < m_poolMeshes.size(); i++)
+		{
+			batchRenderer->submit(m_poolMeshes[i], model);
+		}
 	}
 
 	//Utility functions local to this file
-	ew::Mesh processAiMesh(aiMesh* aiMesh) {
+	ew::MeshData processAiMesh(aiMesh* aiMesh) {
 		ew::MeshData meshData;
-		for (size_t i = 0; i < aiMesh->mNumVertices; i++)
+		const size_t numVertices = aiMesh->mNumVertices;
+		//Sized exactly up front. Attributes missing from the source are zeroed by value initialization
+		meshData.vertices.resize(numVertices);
+		ew::Vertex* vertices = meshData.vertices.data();
+
+		//One branch-free loop per attribute, so each is a straight strided copy
+		const aiVector3D* positions = aiMesh->mVertices;
+		for (size_t i = 0; i < numVertices; i++)
 		{
-			ew::Vertex vertex;
-			vertex.pos = convertAIVec3(aiMesh->mVertices[i]);
-			if (aiMesh->HasNormals()) {
-				vertex.normal = convertAIVec3(aiMesh->mNormals[i]);
+			vertices[i].pos = glm::vec3(positions[i].x, positions[i].y, positions[i].z);
+		}
+		meshData.bounds = ew::computeBounds(vertices, numVertices);
+		if (aiMesh->HasNormals()) {
+			const aiVector3D* normals = aiMesh->mNormals;
+			for (size_t i = 0; i < numVertices; i++)
+			{
+				vertices[i].normal = glm::vec3(normals[i].x, normals[i].y, normals[i].z);
 			}
-			if (aiMesh->HasTextureCoords(0)) {
-				vertex.uv = glm::vec2(convertAIVec3(aiMesh->mTextureCoords[0][i]));
+		}
+		if (aiMesh->HasTextureCoords(0)) {
+			const aiVector3D* uvs = aiMesh->mTextureCoords[0];
+			for (size_t i = 0; i < numVertices; i++)
+			{
+				vertices[i].uv = glm::vec2(uvs[i].x, uvs[i].y);
 			}
-			meshData.vertices.push_back(vertex);
 		}
-		//Convert faces to indices
+
+		//Convert faces to indices. Count first so the index buffer is allocated once
+		size_t numIndices = 0;
+		for (size_t i = 0; i < aiMesh->mNumFaces; i++)
+		{
+			numIndices += aiMesh->mFaces[i].mNumIndices;
+		}
+		meshData.indices.resize(numIndices);
+		unsigned int* indices = meshData.indices.data();
 		for (size_t i = 0; i < aiMesh->mNumFaces; i++)
 		{
-			for (size_t j = 0; j < aiMesh->mFaces[i].mNumIndices; j++)
+			const aiFace& face = aiMesh->mFaces[i];
+			for (size_t j = 0; j < face.mNumIndices; j++)
+			{
+				*indices++ = face.mIndices[j];
+			}
+		}
+		return meshData;
+	}
+
+	//Cache contents depend on options that change mesh data, so they are part of the cache key
+	uint32_t getMeshCacheFlags(const ModelLoadOptions& options) {
+		uint32_t flags = 0;
+		if (options.optimizeMeshes) flags |= 1;
+		if (options.splitLargeMeshes) flags |= 2;
+		return flags;
+	}
+
+	//Applies load options to converted mesh data. May produce several meshes if splitting
+	void processMeshData(ew::MeshData meshData, const ModelLoadOptions& options, std::vector<ew::MeshData>* processed) {
+		size_t first = processed->size();
+		if (options.splitLargeMeshes && meshData.vertices.size() > ew::MAX_16BIT_INDEX_VERTICES) {
+			std::vector<ew::MeshData> submeshes = ew::splitMeshData(meshData);
+			for (size_t i = 0; i < submeshes.size(); i++)
 			{
-				meshData.indices.push_back(aiMesh->mFaces[i].mIndices[j]);
+				processed->push_back(std::move(submeshes[i]));
 			}
 		}
-		return ew::Mesh(meshData);
+		else {
+			processed->push_back(std::move(meshData));
+		}
+		if (options.optimizeMeshes) {
+			for (size_t i = first; i < processed->size(); i++)
+			{
+				ew::optimizeMesh(&(*processed)[i]);
+			}
+		}
+	}
+
+	void Model::addMesh(const ew::MeshData& meshData, const ModelLoadOptions& options) {
+		m_meshPool = options.meshPool;
+		Bounds bounds;
+		if (m_meshPool) {
+			bounds = meshData.bounds.aabb.isValid() ? meshData.bounds : ew::computeBounds(meshData.vertices.data(), meshData.vertices.size());
+			m_poolMeshes.push_back(m_meshPool->add(meshData));
+		}
+		else {
+			//The mesh reuses meshData.bounds or computes them once
+			m_meshes.emplace_back();
+			m_meshes.back().load(meshData, options.vertexFormat);
+			bounds = m_meshes.back().getBounds();
+		}
+		m_meshBounds.push_back(bounds);
+		m_bounds = mergeBounds(m_bounds, bounds);
 	}
 
+	void Model::addMesh(const ew::MeshCacheEntry& cacheEntry, const ModelLoadOptions& options) {
+		Bounds bounds = ew::computeBounds(cacheEntry.vertices, cacheEntry.numVertices);
+		m_meshBounds.push_back(bounds);
+		m_bounds = mergeBounds(m_bounds, bounds);
+		if (m_meshPool) {
+			//The pool only takes 32 bit indices
+			if (cacheEntry.indexType == GL_UNSIGNED_SHORT) {
+				const uint16_t* shortIndices = (const uint16_t*)cacheEntry.indices;
+				std::vector<unsigned int> indices(shortIndices, shortIndices + cacheEntry.numIndices);
+				m_poolMeshes.push_back(m_meshPool->add(cacheEntry.vertices, cacheEntry.numVertices, indices.data(), indices.size()));
+			}
+			else {
+				m_poolMeshes.push_back(m_meshPool->add(cacheEntry.vertices, cacheEntry.numVertices, (const unsigned int*)cacheEntry.indices, cacheEntry.numIndices));
+			}
+		}
+		else {
+			m_meshes.emplace_back();
+			m_meshes.back().load(cacheEntry.vertices, cacheEntry.numVertices, cacheEntry.indices, cacheEntry.numIndices, cacheEntry.indexType, options.vertexFormat, &bounds);
+		}
+	}
 }
@@ -5,14 +5,60 @@
 #pragma once
 #include "mesh.h"
 #include "shader.h"
+#include "meshPool.h"
+#include "batchRenderer.h"
+#include "instanceBuffer.h"
+#include "meshCache.h"
+#include "frustum.h"
 #include <vector>
 
 namespace ew {
+	struct ModelLoadOptions {
+		bool optimizeMeshes = false; //Reorder triangles and vertices for the post-transform cache. See meshOptimizer.h
+		VertexFormat vertexFormat = VertexFormat::STANDARD; //GPU vertex layout for every mesh in the model
+		bool splitLargeMeshes = false; //Split meshes with more than 65535 vertices so every submesh uses 16 bit indices
+		MeshPool* meshPool = nullptr; //If set, meshes are added to this pool instead of getting their own buffers. vertexFormat is ignored
+		bool useMeshCache = false; //Load from a binary cache next to the source file if it is up to date, otherwise import and write one
+	};
+
+	//Loads a model's processed meshes into memory without touching GL. Safe to call from worker threads
+	bool loadModelData(const std::string& filePath, const ModelLoadOptions& options, std::vector<MeshData>* meshes);
+
 	class Model {
 	public:
-		Model(const std::string& filePath);
+		Model() {};
+		Model(const std::string& filePath, const ModelLoadOptions& options = ModelLoadOptions());
+		//Uploads one more mesh into the model. Used to build models incrementally, e.g. by AsyncModelLoader
+		void addMesh(const ew::MeshData& meshData, const ModelLoadOptions& options);
+		//Frees GPU memory for every mesh, or returns them to the pool
+		void unload();
+		size_t getGpuBytes()const;
+		inline size_t getNumMeshes()const { return m_meshPool ? m_poolMeshes.size() : m_meshes.size(); }
 		void draw();
+		//Sets shader's _Dequantize uniform for PACKED_QUANTIZED meshes, see Mesh::draw(const Shader&)
+		void draw(const Shader& shader);
+		//Draws only the meshes whose bounds, transformed by modelMatrix, intersect the frustum
+		//Returns the number of meshes drawn
+		unsigned int draw(const Frustum& frustum, const glm::mat4& modelMatrix);
+		bool isVisible(const Frustum& frustum, const glm::mat4& modelMatrix)const;
+		//Object space bounds of the whole model and of each mesh
+		inline const Bounds& getBounds()const { return m_bounds; }
+		inline const Bounds& getMeshBounds(size_t i)const { return m_meshBounds[i]; }
+		//Attaches per-instance attributes to every mesh. Pooled models attach them to the pool's shared VAO
+		void setInstanceBuffer(const InstanceBuffer* instanceBuffer);
+		void drawInstanced(unsigned int instanceCount);
+		//Culls one instance per model matrix against the model's bounds, uploads the visible ones to instanceBuffer
+		//and draws them. instanceBuffer must be a MAT4 buffer attached with setInstanceBuffer. Returns the number drawn
+		unsigned int drawInstanced(const Frustum& frustum, InstanceBuffer* instanceBuffer, const glm::mat4* models, unsigned int count);
+		//Queues every mesh for batched drawing. Only valid for models loaded into a MeshPool
+		void submit(BatchRenderer* batchRenderer, const glm::mat4& model)const;
 	private:
+		bool loadFromCache(const std::string& filePath, const ModelLoadOptions& options);
+		void addMesh(const ew::MeshCacheEntry& cacheEntry, const ModelLoadOptions& options);
 		std::vector<ew::Mesh> m_meshes;
+		MeshPool* m_meshPool = nullptr;
+		std::vector<MeshPoolHandle> m_poolMeshes;
+		std::vector<Bounds> m_meshBounds; //Parallel to m_meshes or m_poolMeshes
+		Bounds m_bounds;
 	};
 }
\ No newline at end of file
@@ -10,6 +10,16 @@
 using namespace glm;
 
 namespace ew {
+	/// <summary>
+	/// Sets analytic bounds for shapes centered on the origin, so they don't need a pass over the vertices
+	/// </summary>
+	/// <param name="mesh">Mesh to set bounds on</param>
+	/// <param name="extents">Half size of the shape on each axis</param>
+	static void setBounds(MeshData* mesh, vec3 extents) {
+		mesh->bounds.aabb.min = -extents;
+		mesh->bounds.aabb.max = extents;
+		mesh->bounds.sphere = getBoundingSphere(mesh->bounds.aabb);
+	}
 	/// <summary>
 	/// Helper function for createCube. Note that this is not meant to be used standalone
 	/// </summary>
@@ -58,6 +68,7 @@ namespace ew {
 		createCubeFace(vec3{ -1.0f,+0.0f,+0.0f }, size, &mesh); //Left
 		createCubeFace(vec3{ +0.0f,-1.0f,+0.0f }, size, &mesh); //Bottom
 		createCubeFace(vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
+		setBounds(&mesh, vec3(size * 0.5f));
 		return mesh;
 	}
 	MeshData createPlane(float width, float height, int subdivisions)
@@ -93,6 +104,7 @@ namespace ew {
 				mesh.indices.push_back(start);
 			}
 		}
+		setBounds(&mesh, vec3(width * 0.5f, 0.0f, height * 0.5f));
 		return mesh;
 	}
 	MeshData createSphere(float radius, int subdivisions)
@@ -152,6 +164,8 @@ namespace ew {
 			mesh.indices.push_back(sideStart + i + 1);
 			mesh.indices.push_back(poleStart + i);
 		}
+		setBounds(&mesh, vec3(radius));
+		mesh.bounds.sphere.radius = radius;
 		return mesh;
 	}
 	void createCylinderRing(MeshData* meshData, float radius, int subdivisions, float y, bool sideFacing) {
@@ -235,6 +249,7 @@ namespace ew {
 				mesh.indices.push_back(sideStart + i + 1);
 			}
 		}
+		setBounds(&mesh, vec3(radius, height * 0.5f, radius));
 		return mesh;
 	}
 }
\ No newline at end of file
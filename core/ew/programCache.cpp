@@ -0,0 +1,174 @@
+#include "programCache.h"
+#include "fileUtils.h"
+#include "external/glad.h"
+#include <fstream>
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+
+namespace ew {
+	static const char PROGRAM_CACHE_MAGIC[4] = { 'E', 'W', 'P', 'B' };
+
+	struct ProgramCacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint64_t driverHash;
+		uint32_t binaryFormat;
+		uint32_t binarySize;
+	};
+
+	static bool s_programCacheEnabled = true;
+
+	//FNV-1a
+	static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+	/// <summary>
+	/// Identifies the driver that produced a binary. Any driver update changes the version string and invalidates the cache
+	/// </summary>
+	static uint64_t getDriverHash() {
+		uint64_t hash = FNV_OFFSET_BASIS;
+		const GLenum names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (int i = 0; i < 3; i++)
+		{
+			const char* str = (const char*)glGetString(names[i]);
+			if (str) {
+				hash = hashBytes(hash, str, strlen(str) + 1);
+			}
+		}
+		return hash;
+	}
+
+	void setProgramCacheEnabled(bool enabled) {
+		s_programCacheEnabled = enabled;
+	}
+
+	bool isProgramCacheEnabled() {
+		if (!s_programCacheEnabled) {
+			return false;
+		}
+		int numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		return numFormats > 0;
+	}
+
+	uint64_t hashShaderSources(const char* vertexShaderSource, const char* fragmentShaderSource) {
+		//Include the terminators so moving text between stages changes the hash
+		uint64_t hash = hashBytes(FNV_OFFSET_BASIS, vertexShaderSource, strlen(vertexShaderSource) + 1);
+		return hashBytes(hash, fragmentShaderSource, strlen(fragmentShaderSource) + 1);
+	}
+
+	/// <summary>
+	/// Cache file next to the vertex shader, named after both stages, e.g. assets/lit.vert.lit.frag.ewprogram.
+	/// Variants add a hash of their key: assets/lit.vert.lit.frag.1a2b3c4d5e6f7a8b.ewprogram
+	/// </summary>
+	std::string getProgramCachePath(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, const std::string& variantKey) {
+		size_t slash = fragmentShaderPath.find_last_of("/\\");
+		std::string fragmentName = slash == std::string::npos ? fragmentShaderPath : fragmentShaderPath.substr(slash + 1);
+		std::string path = vertexShaderPath + "." + fragmentName;
+		if (!variantKey.empty()) {
+			char hex[17];
+			snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hashBytes(FNV_OFFSET_BASIS, variantKey.data(), variantKey.size()));
+			path += std::string(".") + hex;
+		}
+		return path + ".ewprogram";
+	}
+
+	bool loadProgramBinary(const std::string& cachePath, uint64_t sourceHash, unsigned int* program) {
+		if (!isProgramCacheEnabled()) {
+			return false;
+		}
+		std::ifstream in(cachePath, std::ios::binary);
+		if (!in.is_open()) {
+			return false;
+		}
+		in.seekg(0, std::ios::end);
+		std::streamoff fileSize = in.tellg();
+		in.seekg(0, std::ios::beg);
+		ProgramCacheHeader header;
+		if (!in.read((char*)&header, sizeof(header))
+			|| memcmp(header.magic, PROGRAM_CACHE_MAGIC, 4) != 0
+			|| header.version != PROGRAM_CACHE_VERSION
+			|| header.sourceHash != sourceHash
+			|| header.driverHash != getDriverHash()) {
+			return false;
+		}
+		//A corrupt size must not allocate more than the file could hold
+		if (fileSize < 0 || (uint64_t)header.binarySize > (uint64_t)fileSize - sizeof(header)) {
+			return false;
+		}
+		std::vector<char> binary(header.binarySize);
+		if (!in.read(binary.data(), binary.size())) {
+			return false;
+		}
+		unsigned int cachedProgram = glCreateProgram();
+		glProgramBinary(cachedProgram, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+		//Drivers may reject binaries they produced themselves, e.g. after a hardware change with the same version string
+		int success;
+		glGetProgramiv(cachedProgram, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(cachedProgram);
+			return false;
+		}
+		*program = cachedProgram;
+		return true;
+	}
+
+	/// <summary>
+	/// Writes a linked program's binary. The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	/// </summary>
+	bool saveProgramBinary(const std::string& cachePath, uint64_t sourceHash, unsigned int program) {
+		if (!isProgramCacheEnabled()) {
+			return false;
+		}
+		int linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		int binaryLength = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (!linked || binaryLength <= 0) {
+			return false;
+		}
+		std::vector<char> binary(binaryLength);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(program, binaryLength, NULL, &binaryFormat, binary.data());
+
+		ProgramCacheHeader header;
+		memcpy(header.magic, PROGRAM_CACHE_MAGIC, 4);
+		header.version = PROGRAM_CACHE_VERSION;
+		header.sourceHash = sourceHash;
+		header.driverHash = getDriverHash();
+		header.binaryFormat = binaryFormat;
+		header.binarySize = binary.size();
+
+		//Write to a temporary file and rename, so a crash never leaves a half written cache behind
+		std::string tempPath = getTempFilePath(cachePath);
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) {
+				return false;
+			}
+			out.write((const char*)&header, sizeof(header));
+			out.write(binary.data(), binary.size());
+			if (!out.good()) {
+				out.close();
+				remove(tempPath.c_str());
+				return false;
+			}
+		}
+		remove(cachePath.c_str());
+		if (rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+			//Another writer got there between remove and rename. Its cache holds the same data
+			remove(tempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
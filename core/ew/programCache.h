@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+namespace ew {
+	//Bump whenever the file layout changes. Caches with another version are rebuilt
+	const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+	//On-disk cache of linked program binaries. A binary is only reused when the GLSL sources and the driver
+	//(vendor, renderer and version strings) match the ones it was built with, since binaries are driver specific.
+	void setProgramCacheEnabled(bool enabled);
+	//False if disabled, or the driver supports no binary formats
+	bool isProgramCacheEnabled();
+
+	uint64_t hashShaderSources(const char* vertexShaderSource, const char* fragmentShaderSource);
+	//variantKey separates shader variants built from the same files, see getShaderVariantKey
+	std::string getProgramCachePath(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, const std::string& variantKey = "");
+	//Creates a program from a cached binary. Returns false if the cache is missing, stale or rejected by the driver
+	bool loadProgramBinary(const std::string& cachePath, uint64_t sourceHash, unsigned int* program);
+	bool saveProgramBinary(const std::string& cachePath, uint64_t sourceHash, unsigned int program);
+}
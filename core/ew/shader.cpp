@@ -3,27 +3,117 @@
 */
 
 #include "shader.h"
+#include "uniformBuffer.h"
+#include "programCache.h"
 #include <fstream>
 #include <sstream>
+#include "glState.h"
 #include "external/glad.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <string.h>
 
 namespace ew {
+	static const int MAX_INCLUDE_DEPTH = 16;
+
 	/// <summary>
-	/// Loads shader source code from a file.
+	/// Reads a file and recursively resolves its #include lines. #line directives keep compile errors pointing at the right line
 	/// </summary>
-	/// <param name="filePath"></param>
-	/// <returns></returns>
-	std::string loadShaderSourceFromFile(const std::string& filePath) {
+	static bool resolveIncludes(const std::string& filePath, int depth, std::string* out) {
+		if (depth > MAX_INCLUDE_DEPTH) {
+			printf("Shader include depth exceeded at %s, check for recursive includes\n", filePath.c_str());
+			return false;
+		}
 		std::ifstream fstream(filePath);
 		if (!fstream.is_open()) {
 			printf("Failed to load file %s", filePath.c_str());
+			return false;
+		}
+		size_t slash = filePath.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? "" : filePath.substr(0, slash + 1);
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(fstream, line)) {
+			lineNumber++;
+			size_t start = line.find_first_not_of(" \t");
+			if (start != std::string::npos && line.compare(start, 8, "#include") == 0) {
+				size_t open = line.find('"', start + 8);
+				size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+				if (close == std::string::npos) {
+					printf("Malformed #include in %s line %d\n", filePath.c_str(), lineNumber);
+					return false;
+				}
+				*out += "#line 1\n";
+				if (!resolveIncludes(directory + line.substr(open + 1, close - open - 1), depth + 1, out)) {
+					return false;
+				}
+				*out += "#line " + std::to_string(lineNumber + 1) + "\n";
+				continue;
+			}
+			*out += line;
+			*out += '\n';
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Loads shader source code from a file, resolving #include "file" lines relative to the including file.
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <returns></returns>
+	std::string loadShaderSourceFromFile(const std::string& filePath) {
+		std::string source;
+		if (!resolveIncludes(filePath, 0, &source)) {
 			return {};
 		}
-		std::stringstream buffer;
-		buffer << fstream.rdbuf();
-		return buffer.str();
+		return source;
+	}
+
+	/// <summary>
+	/// Inserts #define lines after the #version line, which must stay first in GLSL
+	/// </summary>
+	/// <param name="source">GLSL source code</param>
+	/// <param name="defines">Names, optionally followed by a space and a value</param>
+	/// <returns></returns>
+	std::string addShaderDefines(const std::string& source, const std::vector<std::string>& defines) {
+		if (defines.empty()) {
+			return source;
+		}
+		size_t insertAt = 0;
+		int versionLine = 0;
+		size_t version = source.find("#version");
+		if (version != std::string::npos) {
+			size_t lineEnd = source.find('\n', version);
+			insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+			versionLine = (int)std::count(source.begin(), source.begin() + version, '\n') + 1;
+		}
+		std::string defineBlock;
+		if (insertAt == source.size() && insertAt > 0 && source.back() != '\n') {
+			defineBlock += '\n';
+		}
+		for (size_t i = 0; i < defines.size(); i++)
+		{
+			defineBlock += "#define " + defines[i] + "\n";
+		}
+		defineBlock += "#line " + std::to_string(versionLine + 1) + "\n";
+		std::string result = source;
+		result.insert(insertAt, defineBlock);
+		return result;
+	}
+
+	std::string getShaderVariantKey(const std::vector<std::string>& defines) {
+		std::vector<std::string> sorted = defines;
+		std::sort(sorted.begin(), sorted.end());
+		std::string key;
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			if (i > 0) {
+				key += ';';
+			}
+			key += sorted[i];
+		}
+		return key;
 	}
 
 	/// <summary>
@@ -61,6 +151,10 @@ namespace ew {
 		unsigned int fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
 
 		unsigned int shaderProgram = glCreateProgram();
+		//Must be set before linking for glGetProgramBinary to work
+		if (isProgramCacheEnabled()) {
+			glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
 		//Attach each stage
 		glAttachShader(shaderProgram, vertexShader);
 		glAttachShader(shaderProgram, fragmentShader);
@@ -83,51 +177,193 @@ namespace ew {
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
 	/// <param name="fragmentShader">File path to fragment shader</param>
-	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader)
+	/// <param name="defines">#defines added to both stages, see addShaderDefines</param>
+	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines)
+	{
+		std::string vertexShaderSource = ew::addShaderDefines(ew::loadShaderSourceFromFile(vertexShader), defines);
+		std::string fragmentShaderSource = ew::addShaderDefines(ew::loadShaderSourceFromFile(fragmentShader), defines);
+		//Reuse the linked binary from a previous run if the sources and driver haven't changed
+		std::string cachePath = ew::getProgramCachePath(vertexShader, fragmentShader, ew::getShaderVariantKey(defines));
+		uint64_t sourceHash = ew::hashShaderSources(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		if (!ew::loadProgramBinary(cachePath, sourceHash, &m_id)) {
+			m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+			ew::saveProgramBinary(cachePath, sourceHash, m_id);
+		}
+		ew::bindUniformBlocks(m_id);
+		reflectUniforms();
+	}
+	/// <summary>
+	/// Creates a shader instance from a program that is already linked
+	/// </summary>
+	/// <param name="program">Linked program handle. The Shader takes it over</param>
+	Shader::Shader(unsigned int program)
+		: m_id(program)
 	{
-		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
-		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
-		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		ew::bindUniformBlocks(m_id);
+		reflectUniforms();
+	}
+	/// <summary>
+	/// Builds the table of active uniforms and their locations, so setters never need glGetUniformLocation.
+	/// Arrays of basic types are reported once as name[0]. Their elements are registered individually, and the bare array name maps to element 0.
+	/// Struct array members like _Lights[1].color are reported one by one and registered as is
+	/// </summary>
+	void Shader::reflectUniforms()
+	{
+		m_uniforms.clear();
+		int numUniforms = 0;
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &numUniforms);
+		int maxNameLength = 0;
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<char> nameBuffer(maxNameLength + 1);
+		auto addUniform = [this](const std::string& name, int location, unsigned int type) {
+			Uniform uniform = {};
+			uniform.hash = uniformHash(name.c_str());
+			uniform.location = location;
+			uniform.type = type;
+			uniform.hasValue = false;
+			m_uniforms.push_back(uniform);
+		};
+		for (int i = 0; i < numUniforms; i++)
+		{
+			int arraySize = 0;
+			GLenum type = 0;
+			glGetActiveUniform(m_id, i, (GLsizei)nameBuffer.size(), NULL, &arraySize, &type, nameBuffer.data());
+			std::string name = nameBuffer.data();
+			int location = glGetUniformLocation(m_id, name.c_str());
+			//Uniforms in blocks have no location
+			if (location < 0) {
+				continue;
+			}
+			addUniform(name, location, type);
+			const size_t suffixLength = 3; //"[0]"
+			if (name.size() > suffixLength && name.compare(name.size() - suffixLength, suffixLength, "[0]") == 0) {
+				std::string baseName = name.substr(0, name.size() - suffixLength);
+				addUniform(baseName, location, type);
+				for (int element = 1; element < arraySize; element++)
+				{
+					std::string elementName = baseName + "[" + std::to_string(element) + "]";
+					addUniform(elementName, glGetUniformLocation(m_id, elementName.c_str()), type);
+				}
+			}
+		}
+		std::sort(m_uniforms.begin(), m_uniforms.end(), [](const Uniform& a, const Uniform& b) {
+			return a.hash != b.hash ? a.hash < b.hash : a.location < b.location;
+		});
+		//Drivers may report an element both on its own and as part of its array
+		m_uniforms.erase(std::unique(m_uniforms.begin(), m_uniforms.end(), [](const Uniform& a, const Uniform& b) {
+			return a.hash == b.hash && a.location == b.location;
+		}), m_uniforms.end());
+		for (size_t i = 1; i < m_uniforms.size(); i++)
+		{
+			if (m_uniforms[i].hash == m_uniforms[i - 1].hash) {
+				printf("Shader: uniform name hash collision, rename one of the uniforms\n");
+			}
+		}
+	}
+	UniformHandle Shader::getUniform(const std::string& name) const
+	{
+		return getUniform(uniformHash(name.c_str()));
+	}
+	UniformHandle Shader::getUniform(uint32_t nameHash) const
+	{
+		UniformHandle handle;
+		auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), nameHash,
+			[](const Uniform& uniform, uint32_t hash) { return uniform.hash < hash; });
+		if (it != m_uniforms.end() && it->hash == nameHash) {
+			handle.slot = (int)(it - m_uniforms.begin());
+		}
+		return handle;
+	}
+	/// <summary>
+	/// Stores a value as the uniform's current value
+	/// </summary>
+	/// <returns>False if the value is the same as the last upload, so the GL call can be skipped</returns>
+	bool Shader::updateCache(UniformHandle handle, const void* data, size_t size) const
+	{
+		Uniform& uniform = m_uniforms[handle.slot];
+		if (uniform.hasValue && memcmp(uniform.value, data, size) == 0) {
+			return false;
+		}
+		memcpy(uniform.value, data, size);
+		uniform.hasValue = true;
+		return true;
 	}
 	void Shader::use()const
 	{
-		glUseProgram(m_id);
+		GLState::useProgram(m_id);
+	}
+	//Setters go through glProgramUniform so values land in this program even when another one is bound.
+	//That keeps the value cache in sync with the program's real state.
+	void Shader::setInt(UniformHandle handle, int v) const
+	{
+		if (handle.isValid() && updateCache(handle, &v, sizeof(v))) {
+			glProgramUniform1i(m_id, m_uniforms[handle.slot].location, v);
+		}
+	}
+	void Shader::setFloat(UniformHandle handle, float v) const
+	{
+		if (handle.isValid() && updateCache(handle, &v, sizeof(v))) {
+			glProgramUniform1f(m_id, m_uniforms[handle.slot].location, v);
+		}
+	}
+	void Shader::setVec2(UniformHandle handle, const glm::vec2& v) const
+	{
+		if (handle.isValid() && updateCache(handle, &v, sizeof(v))) {
+			glProgramUniform2f(m_id, m_uniforms[handle.slot].location, v.x, v.y);
+		}
+	}
+	void Shader::setVec3(UniformHandle handle, const glm::vec3& v) const
+	{
+		if (handle.isValid() && updateCache(handle, &v, sizeof(v))) {
+			glProgramUniform3f(m_id, m_uniforms[handle.slot].location, v.x, v.y, v.z);
+		}
+	}
+	void Shader::setVec4(UniformHandle handle, const glm::vec4& v) const
+	{
+		if (handle.isValid() && updateCache(handle, &v, sizeof(v))) {
+			glProgramUniform4f(m_id, m_uniforms[handle.slot].location, v.x, v.y, v.z, v.w);
+		}
+	}
+	void Shader::setMat4(UniformHandle handle, const glm::mat4& m) const
+	{
+		if (handle.isValid() && updateCache(handle, glm::value_ptr(m), sizeof(glm::mat4))) {
+			glProgramUniformMatrix4fv(m_id, m_uniforms[handle.slot].location, 1, GL_FALSE, glm::value_ptr(m));
+		}
 	}
 	void Shader::setInt(const std::string& name, int v) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		setInt(getUniform(name), v);
 	}
 	void Shader::setFloat(const std::string& name, float v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		setFloat(getUniform(name), v);
 	}
 	void Shader::setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		setVec2(getUniform(name), glm::vec2(x, y));
 	}
 	void Shader::setVec2(const std::string& name, const glm::vec2& v) const
 	{
-		setVec2(name, v.x, v.y);
+		setVec2(getUniform(name), v);
 	}
 	void Shader::setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		setVec3(getUniform(name), glm::vec3(x, y, z));
 	}
 	void Shader::setVec3(const std::string& name, const glm::vec3& v) const
 	{
-		setVec3(name, v.x, v.y, v.z);
+		setVec3(getUniform(name), v);
 	}
 	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		setVec4(getUniform(name), glm::vec4(x, y, z, w));
 	}
 	void Shader::setVec4(const std::string& name, const glm::vec4& v) const
 	{
-		setVec4(name, v.x, v.y, v.z, v.w);
+		setVec4(getUniform(name), v);
 	}
 	void Shader::setMat4(const std::string& name, const glm::mat4& m) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(m));
+		setMat4(getUniform(name), m);
 	}
 }
-
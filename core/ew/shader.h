@@ -4,15 +4,60 @@
 
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 namespace ew {
+	//Loads a shader file, replacing #include "file" lines with the contents of the file, relative to the including file
 	std::string loadShaderSourceFromFile(const std::string& filePath);
+	//Inserts a #define line for each entry after the #version line. Entries are a name, optionally followed by a value: "BIAS_MODE 2"
+	std::string addShaderDefines(const std::string& source, const std::vector<std::string>& defines);
+	//Order independent key of a set of defines. Empty for no defines
+	std::string getShaderVariantKey(const std::vector<std::string>& defines);
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+	//FNV-1a hash of a uniform name. constexpr, so names known at compile time cost nothing at runtime:
+	//	constexpr uint32_t MODEL = ew::uniformHash("_Model");
+	constexpr uint32_t uniformHash(const char* name) {
+		uint32_t hash = 2166136261u;
+		while (*name) {
+			hash = (hash ^ (uint8_t)*name++) * 16777619u;
+		}
+		return hash;
+	}
+
+	//Pre-resolved uniform of one Shader. Invalid handles (uniform not active in the program) are ignored by set calls
+	struct UniformHandle {
+		int slot = -1;
+		inline bool isValid()const { return slot >= 0; }
+	};
+
 	class Shader {
 	public:
-		Shader(const std::string& vertexShader, const std::string& fragmentShader);
+		Shader(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines = {});
+		//Adopts an already linked program, e.g. one built by ShaderCompiler
+		explicit Shader(unsigned int program);
+		//The uniform value cache describes the program, so only one Shader may own it
+		Shader(const Shader&) = delete;
+		Shader& operator=(const Shader&) = delete;
+		Shader(Shader&&) = default;
+		Shader& operator=(Shader&&) = default;
 		void use()const;
+		inline unsigned int getId()const { return m_id; }
+
+		UniformHandle getUniform(const std::string& name)const;
+		UniformHandle getUniform(uint32_t nameHash)const;
+		inline unsigned int getNumUniforms()const { return m_uniforms.size(); }
+
+		//Handle based setters skip the upload if the value hasn't changed since the last set
+		void setInt(UniformHandle handle, int v) const;
+		void setFloat(UniformHandle handle, float v) const;
+		void setVec2(UniformHandle handle, const glm::vec2& v) const;
+		void setVec3(UniformHandle handle, const glm::vec3& v) const;
+		void setVec4(UniformHandle handle, const glm::vec4& v) const;
+		void setMat4(UniformHandle handle, const glm::mat4& m) const;
+
 		void setInt(const std::string& name, int v) const;
 		void setFloat(const std::string& name, float v) const;
 		void setVec2(const std::string& name, float x, float y) const;
@@ -23,6 +68,17 @@ namespace ew {
 		void setVec4(const std::string& name, const glm::vec4& v) const;
 		void setMat4(const std::string& name, const glm::mat4& m) const;
 	private:
+		struct Uniform {
+			uint32_t hash;
+			int location;
+			unsigned int type;
+			float value[16]; //Last uploaded value. ints are stored bitwise
+			bool hasValue;
+		};
+		void reflectUniforms();
+		bool updateCache(UniformHandle handle, const void* data, size_t size) const;
+
 		unsigned int m_id; //Shader program handle
+		mutable std::vector<Uniform> m_uniforms; //Active uniforms, sorted by hash. Raw glUniform calls on the program bypass this cache
 	};
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "shaderCompiler.h"
+#include "programCache.h"
+#include "external/glad.h"
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <string.h>
+#include <stdio.h>
+
+namespace ew {
+	//From KHR_parallel_shader_compile. ARB_parallel_shader_compile uses the same value
+	static const GLenum COMPLETION_STATUS_KHR = 0x91B1;
+	//glad was generated without the extension, so its entry point is looked up at runtime
+	typedef void (GLAD_API_PTR *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+	static double getTimeMs() {
+		using namespace std::chrono;
+		return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	static bool hasExtension(const char* name) {
+		int numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+		for (int i = 0; i < numExtensions; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension && strcmp(extension, name) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Creates a shader object and starts compiling it. Status is not queried, so this doesn't wait for the driver
+	/// </summary>
+	static unsigned int submitShader(GLenum shaderType, const char* sourceCode) {
+		unsigned int shader = glCreateShader(shaderType);
+		glShaderSource(shader, 1, &sourceCode, NULL);
+		glCompileShader(shader);
+		return shader;
+	}
+
+	static void printShaderLog(const std::string& name, unsigned int shader) {
+		int success;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetShaderInfoLog(shader, 512, NULL, infoLog);
+			printf("Failed to compile shader %s: %s", name.c_str(), infoLog);
+		}
+	}
+
+	ShaderCompiler::ShaderCompiler()
+	{
+		bool khr = hasExtension("GL_KHR_parallel_shader_compile");
+		m_parallelCompileSupported = khr || hasExtension("GL_ARB_parallel_shader_compile");
+		if (m_parallelCompileSupported) {
+			//The default number of compiler threads is implementation defined. 0xFFFFFFFF lets the driver use as many as it likes
+			PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress(
+				khr ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB");
+			if (maxShaderCompilerThreads) {
+				maxShaderCompilerThreads(0xFFFFFFFF);
+			}
+		}
+	}
+
+	AsyncShaderHandle ShaderCompiler::add(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines)
+	{
+		double startMs = getTimeMs();
+		AsyncShaderHandle handle = std::make_shared<AsyncShader>();
+		std::string variantKey = ew::getShaderVariantKey(defines);
+		handle->m_name = vertexShader + " + " + fragmentShader + (variantKey.empty() ? "" : " [" + variantKey + "]");
+		m_all.push_back(handle);
+
+		std::string vertexShaderSource = ew::addShaderDefines(ew::loadShaderSourceFromFile(vertexShader), defines);
+		std::string fragmentShaderSource = ew::addShaderDefines(ew::loadShaderSourceFromFile(fragmentShader), defines);
+		handle->m_cachePath = ew::getProgramCachePath(vertexShader, fragmentShader, variantKey);
+		handle->m_sourceHash = ew::hashShaderSources(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		unsigned int program = 0;
+		if (ew::loadProgramBinary(handle->m_cachePath, handle->m_sourceHash, &program)) {
+			handle->m_program = program;
+			handle->m_fromCache = true;
+			handle->m_shader.reset(new Shader(program));
+			handle->m_state = ShaderCompileState::READY;
+			handle->m_submitMs = handle->m_readyMs = getTimeMs() - startMs;
+			return handle;
+		}
+
+		//Compile and link are only submitted here. The link waits for the compiles inside the driver
+		handle->m_vertexShader = submitShader(GL_VERTEX_SHADER, vertexShaderSource.c_str());
+		handle->m_fragmentShader = submitShader(GL_FRAGMENT_SHADER, fragmentShaderSource.c_str());
+		handle->m_program = glCreateProgram();
+		if (isProgramCacheEnabled()) {
+			glProgramParameteri(handle->m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glAttachShader(handle->m_program, handle->m_vertexShader);
+		glAttachShader(handle->m_program, handle->m_fragmentShader);
+		glLinkProgram(handle->m_program);
+		handle->m_submitMs = getTimeMs() - startMs;
+		handle->m_startMs = startMs;
+		m_pending.push_back(handle);
+		return handle;
+	}
+
+	bool ShaderCompiler::isComplete(const AsyncShader& shader) const
+	{
+		if (!m_parallelCompileSupported) {
+			return true;
+		}
+		int complete = 0;
+		glGetProgramiv(shader.m_program, COMPLETION_STATUS_KHR, &complete);
+		return complete != 0;
+	}
+
+	/// <summary>
+	/// Checks the link result of a completed program, caches its binary and wraps it in a Shader
+	/// </summary>
+	void ShaderCompiler::finalize(AsyncShader* shader)
+	{
+		int success;
+		glGetProgramiv(shader->m_program, GL_LINK_STATUS, &success);
+		if (success) {
+			ew::saveProgramBinary(shader->m_cachePath, shader->m_sourceHash, shader->m_program);
+			shader->m_shader.reset(new Shader(shader->m_program));
+			shader->m_state = ShaderCompileState::READY;
+		}
+		else {
+			printShaderLog(shader->m_name, shader->m_vertexShader);
+			printShaderLog(shader->m_name, shader->m_fragmentShader);
+			char infoLog[512];
+			glGetProgramInfoLog(shader->m_program, 512, NULL, infoLog);
+			printf("Failed to link shader program %s: %s", shader->m_name.c_str(), infoLog);
+			glDeleteProgram(shader->m_program);
+			shader->m_program = 0;
+			shader->m_state = ShaderCompileState::FAILED;
+		}
+		glDeleteShader(shader->m_vertexShader);
+		glDeleteShader(shader->m_fragmentShader);
+		shader->m_vertexShader = shader->m_fragmentShader = 0;
+		shader->m_readyMs = getTimeMs() - shader->m_startMs;
+	}
+
+	void ShaderCompiler::update()
+	{
+		for (size_t i = 0; i < m_pending.size();)
+		{
+			if (!isComplete(*m_pending[i])) {
+				i++;
+				continue;
+			}
+			finalize(m_pending[i].get());
+			m_pending.erase(m_pending.begin() + i);
+			//Without completion queries every status check blocks, so only take one per frame
+			if (!m_parallelCompileSupported) {
+				break;
+			}
+		}
+	}
+
+	void ShaderCompiler::finish()
+	{
+		for (size_t i = 0; i < m_pending.size(); i++)
+		{
+			finalize(m_pending[i].get());
+		}
+		m_pending.clear();
+	}
+
+	void ShaderCompiler::printTimingReport() const
+	{
+		printf("Shader compile report (%s)\n", m_parallelCompileSupported ? "parallel compile" : "no parallel compile");
+		double totalSubmitMs = 0.0;
+		for (size_t i = 0; i < m_all.size(); i++)
+		{
+			const AsyncShader& shader = *m_all[i];
+			const char* state = shader.m_fromCache ? "cached" : shader.m_state == ShaderCompileState::READY ? "compiled" : shader.m_state == ShaderCompileState::FAILED ? "failed" : "pending";
+			if (shader.m_state == ShaderCompileState::COMPILING) {
+				printf("  %-8s submit %7.2fms                  %s\n", state, shader.m_submitMs, shader.m_name.c_str());
+			}
+			else {
+				printf("  %-8s submit %7.2fms ready %7.2fms  %s\n", state, shader.m_submitMs, shader.m_readyMs, shader.m_name.c_str());
+			}
+			totalSubmitMs += shader.m_submitMs;
+		}
+		printf("  %u programs, %.2fms submitting\n", (unsigned int)m_all.size(), totalSubmitMs);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "shader.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ew {
+	enum class ShaderCompileState {
+		COMPILING = 0, //Submitted to the driver, compile or link still in flight
+		READY = 1,
+		FAILED = 2
+	};
+
+	//A program compiled in the background by ShaderCompiler. Poll isReady() and skip or substitute draws until then
+	class AsyncShader {
+	public:
+		inline ShaderCompileState getState()const { return m_state; }
+		inline bool isReady()const { return m_state == ShaderCompileState::READY; }
+		inline const std::string& getName()const { return m_name; }
+		//Only valid once isReady() returns true
+		inline Shader* getShader() { return m_shader.get(); }
+		inline bool isFromCache()const { return m_fromCache; }
+		inline double getSubmitMs()const { return m_submitMs; }
+		inline double getReadyMs()const { return m_readyMs; }
+	private:
+		friend class ShaderCompiler;
+		std::string m_name;
+		std::string m_cachePath;
+		uint64_t m_sourceHash = 0;
+		unsigned int m_program = 0;
+		unsigned int m_vertexShader = 0;
+		unsigned int m_fragmentShader = 0;
+		ShaderCompileState m_state = ShaderCompileState::COMPILING;
+		std::unique_ptr<Shader> m_shader;
+		bool m_fromCache = false;
+		double m_startMs = 0.0;
+		double m_submitMs = 0.0; //CPU time spent in ShaderCompiler::add
+		double m_readyMs = 0.0; //Time from add until the program was ready, measured on the next update after completion
+	};
+
+	typedef std::shared_ptr<AsyncShader> AsyncShaderHandle;
+
+	//Submits compile and link of many programs up front and checks their status later, so the driver can compile them in parallel.
+	//With KHR_parallel_shader_compile, update() never blocks on the driver. Without it, update() waits for one program per call.
+	class ShaderCompiler {
+	public:
+		ShaderCompiler();
+		//Loads sources and starts compiling. Programs found in the binary cache are ready immediately
+		AsyncShaderHandle add(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& defines = {});
+		//Call once per frame on the GL thread. Finalizes every program whose compile has completed
+		void update();
+		//Blocks until every submitted program is ready or failed
+		void finish();
+		inline bool isParallelCompileSupported()const { return m_parallelCompileSupported; }
+		inline size_t getNumPending()const { return m_pending.size(); }
+		//Prints submit time, time until ready and cache use of every program added so far
+		void printTimingReport()const;
+	private:
+		bool isComplete(const AsyncShader& shader)const;
+		void finalize(AsyncShader* shader);
+
+		bool m_parallelCompileSupported = false;
+		std::vector<AsyncShaderHandle> m_pending;
+		std::vector<AsyncShaderHandle> m_all;
+	};
+}
@@ -0,0 +1,24 @@
+#include "shaderVariants.h"
+
+namespace ew {
+	ShaderVariants::ShaderVariants(const std::string& vertexShader, const std::string& fragmentShader)
+		: m_vertexShader(vertexShader), m_fragmentShader(fragmentShader)
+	{
+	}
+
+	Shader* ShaderVariants::get(const std::vector<std::string>& defines)
+	{
+		return getByKey(getShaderVariantKey(defines), defines);
+	}
+
+	Shader* ShaderVariants::getByKey(const std::string& key, const std::vector<std::string>& defines)
+	{
+		auto it = m_variants.find(key);
+		if (it != m_variants.end()) {
+			return it->second.get();
+		}
+		Shader* shader = new Shader(m_vertexShader, m_fragmentShader, defines);
+		m_variants[key].reset(shader);
+		return shader;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "shader.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ew {
+	//#define permutations of one vertex + fragment shader pair. Each set of defines is compiled the first time it is requested
+	//and cached, so features can be toggled with #ifdef instead of runtime branches:
+	//	ew::ShaderVariants blur("assets/postprocess.vert", "assets/postprocess.frag");
+	//	blur.get({ "HORIZONTAL" })->use();
+	class ShaderVariants {
+	public:
+		ShaderVariants(const std::string& vertexShader, const std::string& fragmentShader);
+		//Returns the variant for a set of defines. Order of the defines doesn't matter
+		Shader* get(const std::vector<std::string>& defines);
+		//Lookup by a key from getShaderVariantKey, which avoids rebuilding the key every frame
+		Shader* getByKey(const std::string& key, const std::vector<std::string>& defines);
+		inline size_t getNumVariants()const { return m_variants.size(); }
+	private:
+		std::string m_vertexShader;
+		std::string m_fragmentShader;
+		std::unordered_map<std::string, std::unique_ptr<Shader>> m_variants;
+	};
+}
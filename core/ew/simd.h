@@ -0,0 +1,13 @@
+#pragma once
+
+//SSE2 is always available on x64, and on x86 when the compiler targets it. Define EW_NO_SIMD to force scalar code paths
+#if !defined(EW_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define EW_SSE 1
+#include <emmintrin.h>
+#endif
+
+//AVX is only used when the compiler already targets it, e.g. /arch:AVX or -mavx
+#if defined(EW_SSE) && defined(__AVX__)
+#define EW_AVX 1
+#include <immintrin.h>
+#endif
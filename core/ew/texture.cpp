@@ -3,6 +3,7 @@
 */
 
 #include "texture.h"
+#include "glState.h"
 #include "external/glad.h"
 #include "external/stb_image.h"
 
@@ -32,7 +33,7 @@ namespace ew {
 		}
 		unsigned int texture;
 		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
 		int format = getTextureFormat(numComponents);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
@@ -48,7 +49,7 @@ namespace ew {
 			glGenerateMipmap(GL_TEXTURE_2D);
 		}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLState::bindTexture(GL_TEXTURE_2D, 0);
 		stbi_image_free(data);
 		return texture;
 	}
@@ -0,0 +1,108 @@
+#include "threadPool.h"
+#include <atomic>
+#include <algorithm>
+
+namespace ew {
+	ThreadPool::ThreadPool(unsigned int numThreads)
+	{
+		if (numThreads == 0) {
+			unsigned int cores = std::thread::hardware_concurrency();
+			numThreads = cores > 1 ? cores - 1 : 1;
+		}
+		m_workers.reserve(numThreads);
+		for (unsigned int i = 0; i < numThreads; i++)
+		{
+			m_workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_condition.notify_all();
+		for (size_t i = 0; i < m_workers.size(); i++)
+		{
+			m_workers[i].join();
+		}
+	}
+
+	void ThreadPool::enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push(std::move(task));
+		}
+		m_condition.notify_one();
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+				//Remaining tasks are still run on shutdown so futures never break
+				if (m_tasks.empty()) {
+					return;
+				}
+				task = std::move(m_tasks.front());
+				m_tasks.pop();
+			}
+			task();
+		}
+	}
+
+	void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn)
+	{
+		if (count == 0) {
+			return;
+		}
+		if (count == 1 || m_workers.empty()) {
+			for (size_t i = 0; i < count; i++)
+			{
+				fn(i);
+			}
+			return;
+		}
+		//Shared so helpers that only start after the caller returns still see valid state
+		struct State {
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> done{ 0 };
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+		auto state = std::make_shared<State>();
+		const std::function<void(size_t)>* function = &fn;
+		auto work = [state, function, count]() {
+			size_t completed = 0;
+			for (size_t i = state->next++; i < count; i = state->next++)
+			{
+				(*function)(i);
+				completed++;
+			}
+			if (completed > 0 && state->done.fetch_add(completed) + completed == count) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		};
+		//fn is only dereferenced while indices remain, and the caller doesn't return before then
+		size_t numHelpers = std::min(count - 1, m_workers.size());
+		for (size_t i = 0; i < numHelpers; i++)
+		{
+			enqueue(work);
+		}
+		work();
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&]() { return state->done.load() == count; });
+	}
+
+	ThreadPool& ThreadPool::getShared()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ew {
+	//Fixed set of worker threads pulling tasks from a shared queue
+	class ThreadPool {
+	public:
+		//0 uses one thread per hardware core, minus one for the calling thread
+		ThreadPool(unsigned int numThreads = 0);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template<typename F>
+		auto submit(F&& task) -> std::future<decltype(task())> {
+			using Result = decltype(task());
+			auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+			std::future<Result> future = packaged->get_future();
+			enqueue([packaged]() { (*packaged)(); });
+			return future;
+		}
+
+		//Calls fn(i) for every i in [0, count) across the workers and the calling thread. Blocks until all calls return.
+		//Safe to call from inside a task, since the caller keeps working until every index is done.
+		void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+		inline unsigned int getNumThreads()const { return m_workers.size(); }
+
+		//Process-wide pool shared by loaders and other systems
+		static ThreadPool& getShared();
+	private:
+		void enqueue(std::function<void()> task);
+		void workerLoop();
+
+		std::vector<std::thread> m_workers;
+		std::queue<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+	};
+}
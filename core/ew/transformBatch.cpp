@@ -0,0 +1,227 @@
+#include "transformBatch.h"
+#include "simd.h"
+
+namespace ew {
+	glm::mat4 composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+		//Rotation matrix columns scaled per axis, translation in the last column
+		const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+		glm::mat4 m;
+		m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f);
+		m[1] = glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f);
+		m[2] = glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f);
+		m[3] = glm::vec4(position, 1.0f);
+		return m;
+	}
+
+	void TransformSoA::resize(size_t count)
+	{
+		positionX.resize(count);
+		positionY.resize(count);
+		positionZ.resize(count);
+		rotationX.resize(count);
+		rotationY.resize(count);
+		rotationZ.resize(count);
+		rotationW.resize(count);
+		scaleX.resize(count);
+		scaleY.resize(count);
+		scaleZ.resize(count);
+	}
+
+	void TransformSoA::clear()
+	{
+		resize(0);
+	}
+
+	void TransformSoA::set(size_t i, const Transform& transform)
+	{
+		positionX[i] = transform.position.x;
+		positionY[i] = transform.position.y;
+		positionZ[i] = transform.position.z;
+		rotationX[i] = transform.rotation.x;
+		rotationY[i] = transform.rotation.y;
+		rotationZ[i] = transform.rotation.z;
+		rotationW[i] = transform.rotation.w;
+		scaleX[i] = transform.scale.x;
+		scaleY[i] = transform.scale.y;
+		scaleZ[i] = transform.scale.z;
+	}
+
+	void TransformSoA::push_back(const Transform& transform)
+	{
+		resize(size() + 1);
+		set(size() - 1, transform);
+	}
+
+	Transform TransformSoA::get(size_t i) const
+	{
+		Transform transform;
+		transform.position = glm::vec3(positionX[i], positionY[i], positionZ[i]);
+		transform.rotation = glm::quat(rotationW[i], rotationX[i], rotationY[i], rotationZ[i]);
+		transform.scale = glm::vec3(scaleX[i], scaleY[i], scaleZ[i]);
+		return transform;
+	}
+
+	Affine3x4 toAffine3x4(const glm::mat4& m) {
+		Affine3x4 affine;
+		for (int r = 0; r < 3; r++)
+		{
+			affine.rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+		}
+		return affine;
+	}
+
+	static glm::mat4 composeScalar(const TransformSoA& transforms, size_t i) {
+		return composeTRS(glm::vec3(transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i]),
+			glm::quat(transforms.rotationW[i], transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i]),
+			glm::vec3(transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]));
+	}
+
+#ifdef EW_SSE
+	//Matrix elements of 4 transforms, one per lane: column 0 xyz, column 1 xyz, column 2 xyz, translation xyz.
+	//Same operations in the same order as composeTRS, so results are bitwise equal
+	static inline void composeSSE(const TransformSoA& t, size_t i, __m128 m[12]) {
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		__m128 x = _mm_loadu_ps(&t.rotationX[i]);
+		__m128 y = _mm_loadu_ps(&t.rotationY[i]);
+		__m128 z = _mm_loadu_ps(&t.rotationZ[i]);
+		__m128 w = _mm_loadu_ps(&t.rotationW[i]);
+		__m128 sx = _mm_loadu_ps(&t.scaleX[i]);
+		__m128 sy = _mm_loadu_ps(&t.scaleY[i]);
+		__m128 sz = _mm_loadu_ps(&t.scaleZ[i]);
+		__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+		m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		m[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		m[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+		m[3] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		m[4] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		m[5] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+		m[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		m[7] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		m[8] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+		m[9] = _mm_loadu_ps(&t.positionX[i]);
+		m[10] = _mm_loadu_ps(&t.positionY[i]);
+		m[11] = _mm_loadu_ps(&t.positionZ[i]);
+	}
+
+	//Transposes the lanes back into one column major matrix per transform
+	static inline void storeMat4SSE(const __m128 m[12], glm::mat4* out) {
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		for (int c = 0; c < 4; c++)
+		{
+			__m128 cx = m[c * 3], cy = m[c * 3 + 1], cz = m[c * 3 + 2], cw = c == 3 ? one : zero;
+			_MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+			_mm_storeu_ps(&out[0][c][0], cx);
+			_mm_storeu_ps(&out[1][c][0], cy);
+			_mm_storeu_ps(&out[2][c][0], cz);
+			_mm_storeu_ps(&out[3][c][0], cw);
+		}
+	}
+
+	static inline void storeAffineSSE(const __m128 m[12], Affine3x4* out) {
+		for (int r = 0; r < 3; r++)
+		{
+			__m128 r0 = m[r], r1 = m[3 + r], r2 = m[6 + r], r3 = m[9 + r];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(&out[0].rows[r][0], r0);
+			_mm_storeu_ps(&out[1].rows[r][0], r1);
+			_mm_storeu_ps(&out[2].rows[r][0], r2);
+			_mm_storeu_ps(&out[3].rows[r][0], r3);
+		}
+	}
+#endif
+
+#ifdef EW_AVX
+	//composeSSE for 8 transforms. Each result is split into two halves of 4 for storing
+	static inline void composeAVX(const TransformSoA& t, size_t i, __m128 lo[12], __m128 hi[12]) {
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		__m256 x = _mm256_loadu_ps(&t.rotationX[i]);
+		__m256 y = _mm256_loadu_ps(&t.rotationY[i]);
+		__m256 z = _mm256_loadu_ps(&t.rotationZ[i]);
+		__m256 w = _mm256_loadu_ps(&t.rotationW[i]);
+		__m256 sx = _mm256_loadu_ps(&t.scaleX[i]);
+		__m256 sy = _mm256_loadu_ps(&t.scaleY[i]);
+		__m256 sz = _mm256_loadu_ps(&t.scaleZ[i]);
+		__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+		__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+		__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+		__m256 m[12];
+		m[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+		m[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+		m[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+		m[3] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+		m[4] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+		m[5] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+		m[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+		m[7] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+		m[8] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+		m[9] = _mm256_loadu_ps(&t.positionX[i]);
+		m[10] = _mm256_loadu_ps(&t.positionY[i]);
+		m[11] = _mm256_loadu_ps(&t.positionZ[i]);
+		for (int e = 0; e < 12; e++)
+		{
+			lo[e] = _mm256_castps256_ps128(m[e]);
+			hi[e] = _mm256_extractf128_ps(m[e], 1);
+		}
+	}
+#endif
+
+	void composeMatrices(const TransformSoA& transforms, glm::mat4* out) {
+		const size_t count = transforms.size();
+		size_t i = 0;
+#ifdef EW_AVX
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128 lo[12], hi[12];
+			composeAVX(transforms, i, lo, hi);
+			storeMat4SSE(lo, out + i);
+			storeMat4SSE(hi, out + i + 4);
+		}
+#endif
+#ifdef EW_SSE
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 m[12];
+			composeSSE(transforms, i, m);
+			storeMat4SSE(m, out + i);
+		}
+#endif
+		for (; i < count; i++)
+		{
+			out[i] = composeScalar(transforms, i);
+		}
+	}
+
+	void composeAffineMatrices(const TransformSoA& transforms, Affine3x4* out) {
+		const size_t count = transforms.size();
+		size_t i = 0;
+#ifdef EW_AVX
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128 lo[12], hi[12];
+			composeAVX(transforms, i, lo, hi);
+			storeAffineSSE(lo, out + i);
+			storeAffineSSE(hi, out + i + 4);
+		}
+#endif
+#ifdef EW_SSE
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 m[12];
+			composeSSE(transforms, i, m);
+			storeAffineSSE(m, out + i);
+		}
+#endif
+		for (; i < count; i++)
+		{
+			out[i] = toAffine3x4(composeScalar(transforms, i));
+		}
+	}
+}
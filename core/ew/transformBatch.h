@@ -0,0 +1,36 @@
+#pragma once
+#include "transform.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+namespace ew {
+	//Builds the matrix of a translation, rotation and scale without going through full 4x4 multiplies.
+	//Same result as Transform::modelMatrix()
+	glm::mat4 composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+	//Transforms stored one array per component, so several can be loaded into one SIMD register
+	struct TransformSoA {
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+
+		inline size_t size()const { return positionX.size(); }
+		void resize(size_t count);
+		void clear();
+		void set(size_t i, const Transform& transform);
+		void push_back(const Transform& transform);
+		Transform get(size_t i)const;
+	};
+
+	//Top 3 rows of an affine matrix, row major. The last row is always (0,0,0,1), so this is 48 bytes instead of 64.
+	//Rebuilt in a shader with: mat4 model = transpose(mat4(iRow0, iRow1, iRow2, vec4(0, 0, 0, 1)));
+	struct Affine3x4 {
+		glm::vec4 rows[3];
+	};
+	Affine3x4 toAffine3x4(const glm::mat4& m);
+
+	//Same results as composeTRS for every transform, 8 at a time with AVX or 4 with SSE. See simd.h
+	void composeMatrices(const TransformSoA& transforms, glm::mat4* out);
+	void composeAffineMatrices(const TransformSoA& transforms, Affine3x4* out);
+}
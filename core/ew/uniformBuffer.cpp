@@ -0,0 +1,83 @@
+#include "uniformBuffer.h"
+#include "camera.h"
+#include "external/glad.h"
+#include <vector>
+
+namespace ew {
+	struct UniformBlockName {
+		std::string name;
+		unsigned int binding;
+	};
+
+	static std::vector<UniformBlockName>& getUniformBlockNames() {
+		static std::vector<UniformBlockName> names = {
+			{ "_FrameData", (unsigned int)UniformBlockBinding::FRAME },
+			{ "_ViewData", (unsigned int)UniformBlockBinding::VIEW },
+			{ "_MaterialData", (unsigned int)UniformBlockBinding::MATERIAL }
+		};
+		return names;
+	}
+
+	void registerUniformBlock(const std::string& blockName, unsigned int binding) {
+		std::vector<UniformBlockName>& names = getUniformBlockNames();
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (names[i].name == blockName) {
+				names[i].binding = binding;
+				return;
+			}
+		}
+		names.push_back(UniformBlockName{ blockName, binding });
+	}
+
+	void bindUniformBlocks(unsigned int program) {
+		int numBlocks = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
+		if (numBlocks == 0) {
+			return;
+		}
+		const std::vector<UniformBlockName>& names = getUniformBlockNames();
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			unsigned int blockIndex = glGetUniformBlockIndex(program, names[i].name.c_str());
+			if (blockIndex != GL_INVALID_INDEX) {
+				glUniformBlockBinding(program, blockIndex, names[i].binding);
+			}
+		}
+	}
+
+	ViewBlock makeViewBlock(const Camera& camera) {
+		ViewBlock block;
+		block.view = camera.viewMatrix();
+		block.projection = camera.projectionMatrix();
+		block.viewProjection = camera.viewProjectionMatrix();
+		block.eyePos = glm::vec4(camera.position, 1.0f);
+		return block;
+	}
+
+	UniformBufferBase::UniformBufferBase(size_t size)
+		: m_size(size)
+	{
+		glGenBuffers(1, &m_id);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+		glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	UniformBufferBase::~UniformBufferBase()
+	{
+		glDeleteBuffers(1, &m_id);
+	}
+
+	void UniformBufferBase::bind(unsigned int binding) const
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_id);
+	}
+
+	void UniformBufferBase::upload(const void* data)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, m_size, data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <string.h>
+
+namespace ew {
+	//Binding points of the standard blocks. Every Shader links blocks with these names to these points at link time:
+	//	layout(std140) uniform _FrameData { float _Time; float _DeltaTime; vec4 _LightDirection; mat4 _LightSpaceMatrix; };
+	//	layout(std140) uniform _ViewData { mat4 _View; mat4 _Projection; mat4 _ViewProjection; vec4 _EyePos; };
+	//	layout(std140) uniform _MaterialData { float _Ka; float _Kd; float _Ks; float _Shininess; };
+	enum class UniformBlockBinding {
+		FRAME = 0,
+		VIEW = 1,
+		MATERIAL = 2,
+		USER = 3 //First binding point free for registerUniformBlock
+	};
+
+	//std140 mirrors of the standard blocks. vec3s are stored as vec4 to match std140 alignment
+	struct FrameBlock {
+		float time = 0.0f;
+		float deltaTime = 0.0f;
+		float padding[2] = { 0.0f, 0.0f };
+		glm::vec4 lightDirection = glm::vec4(0.0f);
+		glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+	};
+	struct ViewBlock {
+		glm::mat4 view = glm::mat4(1.0f);
+		glm::mat4 projection = glm::mat4(1.0f);
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+		glm::vec4 eyePos = glm::vec4(0.0f);
+	};
+	struct MaterialBlock {
+		float ka = 1.0f;
+		float kd = 0.5f;
+		float ks = 0.5f;
+		float shininess = 128.0f;
+	};
+	struct Camera;
+	//View block of a camera, e.g. the main camera or a shadow casting light
+	ViewBlock makeViewBlock(const Camera& camera);
+
+	static_assert(sizeof(FrameBlock) % 16 == 0 && sizeof(ViewBlock) % 16 == 0 && sizeof(MaterialBlock) % 16 == 0, "std140 blocks must be vec4 aligned");
+
+	//Adds a block name that every Shader created afterwards links to the given binding point
+	void registerUniformBlock(const std::string& blockName, unsigned int binding);
+	//Links every registered block the program declares to its binding point. Called by Shader after linking
+	void bindUniformBlocks(unsigned int program);
+
+	//GPU buffer holding one block. Written once per frame/view/material and shared by every shader through its binding point
+	class UniformBufferBase {
+	public:
+		UniformBufferBase(size_t size);
+		~UniformBufferBase();
+		UniformBufferBase(const UniformBufferBase&) = delete;
+		UniformBufferBase& operator=(const UniformBufferBase&) = delete;
+		//Binds the buffer to a binding point, e.g. to switch between camera and light views between passes
+		void bind(unsigned int binding)const;
+		inline unsigned int getId()const { return m_id; }
+	protected:
+		void upload(const void* data);
+		unsigned int m_id = 0;
+		size_t m_size = 0;
+	};
+
+	template<typename T>
+	class UniformBuffer : public UniformBufferBase {
+	public:
+		UniformBuffer() : UniformBufferBase(sizeof(T)) {}
+		//Uploads the block unless it is identical to the last upload
+		void set(const T& data) {
+			if (m_hasData && memcmp(&m_data, &data, sizeof(T)) == 0) {
+				return;
+			}
+			m_data = data;
+			m_hasData = true;
+			upload(&m_data);
+		}
+		inline const T& get()const { return m_data; }
+		inline void bind(UniformBlockBinding binding)const { UniformBufferBase::bind((unsigned int)binding); }
+		using UniformBufferBase::bind;
+	private:
+		T m_data;
+		bool m_hasData = false;
+	};
+}